@@ -5,6 +5,151 @@
 
 using namespace std;
 
+//Results of a placement feasibility check
+#define PLACEMENT_FEASIBLE 0
+#define PLACEMENT_OVERLAP 1
+#define PLACEMENT_BIN_WEIGHT 2
+#define PLACEMENT_AREA_SUPPORT 3
+#define PLACEMENT_CORNER_SUPPORT 4
+#define PLACEMENT_LOAD_BEARING 5
+
+//Support information of an item placement, collected during its feasibility check
+struct PlacementSupport
+{
+	int x, y, z;						//Coordinates of the front bottom left corner of the placed item
+	double totalOverlap;				//Total width-depth overlap with the supporting items
+	vector<int> supportedItems;			//List of items that support the placed item
+	vector<double> supportPercentages;	//Percentage of support for the supporting items
+	vector<int> loadedItems;			//List of items whose supported weight increases with the placement
+	vector<double> addedWeights;		//Weight added on each of the loaded items
+};
+
+//AVX2 collision kernels: built for AVX2 when the whole build targets it (-mavx2, or /arch:AVX2 with MSVC), otherwise built for AVX2 alone
+//and selected at run time on the CPUs that have it (GCC and Clang on x86), the other builds use the scalar loop
+#if defined(__AVX2__)
+#define COLLISION_AVX2
+#define COLLISION_AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COLLISION_AVX2
+#define COLLISION_AVX2_DISPATCH
+#define COLLISION_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#ifdef COLLISION_AVX2
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+@param a mask with at least one bit set
+@return the position of the lowest set bit of the mask
+*/
+inline int lowestSetBit(int mask)
+{
+#ifdef _MSC_VER
+	unsigned long position;
+	_BitScanForward(&position, (unsigned long)mask);
+	return (int)position;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+/**
+Test a box for collisions with 8 placed boxes with AVX2
+Boxes that only touch do not collide
+@param x, y, z coordinates and width, depth, height dimensions of the box, and the coordinate and dimension lists of the placed boxes, starting at the first of the 8
+@return a mask with bit k set if the box collides with placed box k
+*/
+COLLISION_AVX2_TARGET inline int collisionMask8(int x, int y, int z, int w, int d, int h, const int *xs, const int *ys, const int *zs, const int *ws, const int *ds, const int *hs)
+{
+	//Boxes collide if they are not apart along any axis: every end of one is past the start of the other
+	__m256i boxX = _mm256_set1_epi32(x), boxY = _mm256_set1_epi32(y), boxZ = _mm256_set1_epi32(z);
+	__m256i placedX = _mm256_loadu_si256((const __m256i*)xs), placedY = _mm256_loadu_si256((const __m256i*)ys), placedZ = _mm256_loadu_si256((const __m256i*)zs);
+	__m256i collides = _mm256_and_si256(
+		_mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(x + w), placedX), _mm256_cmpgt_epi32(_mm256_set1_epi32(y + d), placedY)),
+		_mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(z + h), placedZ), _mm256_cmpgt_epi32(_mm256_add_epi32(placedX, _mm256_loadu_si256((const __m256i*)ws)), boxX)));
+	collides = _mm256_and_si256(collides, _mm256_and_si256(
+		_mm256_cmpgt_epi32(_mm256_add_epi32(placedY, _mm256_loadu_si256((const __m256i*)ds)), boxY),
+		_mm256_cmpgt_epi32(_mm256_add_epi32(placedZ, _mm256_loadu_si256((const __m256i*)hs)), boxZ)));
+	return _mm256_movemask_ps(_mm256_castsi256_ps(collides));
+}
+
+/**
+Find the first of a list of placed boxes that collides with a box, 8 placed boxes at a time with AVX2
+@param the number of placed boxes, x, y, z coordinates and width, depth, height dimensions of the box, and the coordinate and dimension lists of the placed boxes
+@return the index of the first colliding placed box, -1 if the box does not collide with any
+*/
+COLLISION_AVX2_TARGET inline int findCollisionAvx2(int nbBoxes, int x, int y, int z, int w, int d, int h, const int *xs, const int *ys, const int *zs, const int *ws, const int *ds, const int *hs)
+{
+	int k = 0;
+	for (; k + 8 <= nbBoxes; k += 8)
+	{
+		int mask = collisionMask8(x, y, z, w, d, h, xs + k, ys + k, zs + k, ws + k, ds + k, hs + k);
+		if (mask != 0)
+			return k + lowestSetBit(mask);
+	}
+
+	//Remaining boxes
+	for (; k < nbBoxes; k++)
+	{
+		if (x + w > xs[k] && y + d > ys[k] && z + h > zs[k] && xs[k] + ws[k] > x && ys[k] + ds[k] > y && zs[k] + hs[k] > z)
+			return k;
+	}
+	return -1;
+}
+#endif
+
+/**
+Calculate the front bottom left corner of an item that is placed with one of its corners at an extreme point
+@param an extreme point, width and depth dimensions of the item, the corner of the item placed at the extreme point, and the x, y coordinates to be set
+*/
+void cornerOrigin(const extremePoint &EP, int w, int d, int corner, int &x, int &y)
+{
+	//Corners->  0: front left		1: back left		2: front right		3: back right
+	if (corner == 0 || corner == 1)
+		x = EP.x;
+	else
+		x = EP.x - w;
+
+	if (corner == 0 || corner == 2)
+		y = EP.y;
+	else
+		y = EP.y - d;
+}
+
+/**
+Update the infeasibility counters with the result of placement feasibility checks
+@param the result of the checks and the number of checks with that result
+*/
+void countInfeasibility(int result, int count)
+{
+	if (result == PLACEMENT_BIN_WEIGHT)
+		infBinWeight += count;
+	else if (result == PLACEMENT_AREA_SUPPORT)
+		infAreaSupport += count;
+	else if (result == PLACEMENT_CORNER_SUPPORT)
+		inf4CSupport += count;
+	else if (result == PLACEMENT_LOAD_BEARING)
+		infLoadBearing += count;
+}
+
+/**
+Write the support information of a feasible placement to an item list
+@param an item list, the ID of the placed item, and the support information of the placement
+*/
+void applyPlacementSupport(vector<Item> &items, int ID, const PlacementSupport &support)
+{
+	for (int j = 0; j < support.loadedItems.size(); j++)
+	{
+		items[support.loadedItems[j]].totalSupportedWeight += support.addedWeights[j];
+	}
+
+	items[ID].supportedItems = support.supportedItems;
+	items[ID].supportPercentages = support.supportPercentages;
+}
+
 //Class definition for a bin
 struct Bin
 {
@@ -17,7 +162,7 @@ struct Bin
 	int weight;						//Total weight of a bin
 
 	//Default constructor
-	struct Bin()
+	Bin()
 	{
 		this->height = 0;
 		this->weight = 0;
@@ -98,6 +243,9 @@ struct Bin
 				}
 			}
 		}
+
+		//Update the free space of the existing extreme points
+		updateEPSpace(x, y, z, width, depth, height);
 	}
 
 	/**
@@ -167,9 +315,51 @@ struct Bin
 		if (z + height > this->height) this->height = z + height;
 		this->weight += uniqueItemList[ID].weight;
 
+		//Update the free space of the existing extreme points
+		updateEPSpace(x, y, z, width, depth, height);
+
 		//cout << epList.size() << endl;
 	}
 
+	/**
+	Find an item in the bin that collides with a box, 8 items at a time with AVX2 when the CPU has it
+	@param x, y, z coordinates and width, depth, height dimensions of the box
+	@return the index of the first colliding item in the bin, -1 if the box does not collide with any item
+	*/
+	int findCollision(int x, int y, int z, int w, int d, int h) const
+	{
+		int nbItems = this->itemWidths.size();
+#ifdef COLLISION_AVX2_DISPATCH
+		static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+		if (hasAvx2)
+			return findCollisionAvx2(nbItems, x, y, z, w, d, h, this->itemXCoords.data(), this->itemYCoords.data(), this->itemZCoords.data(),
+				this->itemWidths.data(), this->itemDepths.data(), this->itemHeights.data());
+#elif defined(COLLISION_AVX2)
+		return findCollisionAvx2(nbItems, x, y, z, w, d, h, this->itemXCoords.data(), this->itemYCoords.data(), this->itemZCoords.data(),
+			this->itemWidths.data(), this->itemDepths.data(), this->itemHeights.data());
+#endif
+
+		//Scalar loop, stops at the first colliding item
+		for (int binIt = 0; binIt < nbItems; binIt++)
+		{
+			if (x + w > this->itemXCoords[binIt] && y + d > this->itemYCoords[binIt] && z + h > this->itemZCoords[binIt] &&
+				this->itemXCoords[binIt] + this->itemWidths[binIt] > x && this->itemYCoords[binIt] + this->itemDepths[binIt] > y && this->itemZCoords[binIt] + this->itemHeights[binIt] > z)
+				return binIt;
+		}
+
+		return -1;
+	}
+
+	/**
+	Test candidate boxes for collisions with the items in the bin
+	@param the number of candidates, their x, y, z coordinates and width, depth, height dimensions, and the list that gets 1 for the candidates that collide and 0 for the others
+	*/
+	void testCollisions(int nbCandidates, const int *xs, const int *ys, const int *zs, const int *ws, const int *ds, const int *hs, char *collides) const
+	{
+		for (int k = 0; k < nbCandidates; k++)
+			collides[k] = this->findCollision(xs[k], ys[k], zs[k], ws[k], ds[k], hs[k]) >= 0 ? 1 : 0;
+	}
+
 	/**
 	Check the feasibility of placing an item at an extreme point, considering toggled practical constrailts and overlaps
 	@param an extreme point and an item object, and width, depth, height dimensions of the item
@@ -177,190 +367,153 @@ struct Bin
 	*/
 	bool checkFeasibility(extremePoint EP, Item i, int curW, int curD, int curH, int corner)
 	{
-		//Set up lists and parameters for the implementation
+		PlacementSupport support;
+		int result = evaluatePlacement(EP, i, curW, curD, curH, corner, uniqueItemList, support);
+		countInfeasibility(result, 1);
+
+		if (result != PLACEMENT_FEASIBLE)
+			return false;
+
+		//Make a copy of the unique item list and update the current item's support info in it
 		cpyUnique = uniqueItemList;
-		bool feasibilityFlag = false;
-		vector<int> supportingItems;
-		vector<int> supportedItems;
+		if (support.z > 0)
+			applyPlacementSupport(cpyUnique, i.ID, support);
+
+		return true;
+	}
+
+	/**
+	Check the feasibility of placing an item at an extreme point without changing the bin or the item lists, so that placements can be checked in parallel
+	@param an extreme point and an item object, width, depth, height dimensions of the item, the corner of the item placed at the extreme point,
+	the item list with the current support information, and the support structure to be filled
+	@return PLACEMENT_FEASIBLE if the item can be feasibly placed in the bin, the reason of the infeasibility otherwise
+	*/
+	int evaluatePlacement(const extremePoint &EP, const Item &i, int curW, int curD, int curH, int corner, const vector<Item> &items, PlacementSupport &support) const
+	{
+		//Check if the weight limit is exceeded by the placement of the item
+		if (this->weight + i.weight > maxBinWeight)
+			return PLACEMENT_BIN_WEIGHT;
+
+		//If the placed item overlaps with an item in the bin, the placement is infeasible
+		int curX, curY;
+		cornerOrigin(EP, curW, curD, corner, curX, curY);
+		if (this->findCollision(curX, curY, EP.z, curW, curD, curH) >= 0)
+			return PLACEMENT_OVERLAP;
+
+		return this->evaluateSupport(EP, i, curW, curD, curH, corner, items, support);
+	}
+
+	/**
+	Check the support and load bearing of placing an item at an extreme point, for callers that already checked the bin weight and the collisions, such as findBestPlacement
+	@param an extreme point and an item object, width, depth, height dimensions of the item, the corner of the item placed at the extreme point,
+	the item list with the current support information, and the support structure to be filled
+	@return PLACEMENT_FEASIBLE if the item is supported, the reason of the infeasibility otherwise
+	*/
+	int evaluateSupport(const extremePoint &EP, const Item &i, int curW, int curD, int curH, int corner, const vector<Item> &items, PlacementSupport &support) const
+	{
 		//Tracker for the support on the corners of the item. 1 if a corner is supported.
-		vector<int> cornerSupport(4, 0);	//indices for corners->  0: front bottom left	1: back bottom left		2: front bottom right	3: back bottom right
+		int cornerSupport[4] = { 0, 0, 0, 0 };	//indices for corners->  0: front bottom left	1: back bottom left		2: front bottom right	3: back bottom right
 		vector<double> supportAreas;
-		vector<double> supportPercentages;
-		double totalOverlap = 0;
 		int curX, curY, curZ;
+		cornerOrigin(EP, curW, curD, corner, curX, curY);
 		curZ = EP.z;
-		if (corner == 0)
-		{
-			curX = EP.x; curY = EP.y;
-		}
-		else if (corner == 1)
-		{
-			curX = EP.x; curY = EP.y - curD;
-		}
-		else if (corner == 2)
-		{
-			curX = EP.x - curW; curY = EP.y;
-		}
-		else if (corner == 3)
-		{
-			curX = EP.x - curW; curY = EP.y - curD;
-		}
-		
 
-		//Check if the weight limit is exceeded by the placement of the item
-		if (this->weight + i.weight > maxBinWeight)
-		{
-			infBinWeight++;
-			return false;
-		}
-		
-		if (curZ > 0)	//If the item is not being placed at the bottom of a bin
+		support.x = curX; support.y = curY; support.z = curZ;
+		support.totalOverlap = 0;
+		support.supportedItems.clear();
+		support.supportPercentages.clear();
+		support.loadedItems.clear();
+		support.addedWeights.clear();
+
+		//Loop over items in the bin
+		for (int binIt = 0; binIt < itemWidths.size() && curZ > 0; binIt++)
 		{
-			//Loop over items in the bin
-			for (int binIt = 0; binIt < itemWidths.size(); binIt++)
+			int binX, binY, binZ, binW, binD, binH;
+			binX = this->itemXCoords[binIt];
+			binY = this->itemYCoords[binIt];
+			binZ = this->itemZCoords[binIt];
+			binW = this->itemWidths[binIt];
+			binD = this->itemDepths[binIt];
+			binH = this->itemHeights[binIt];
+
+			//If the placement is in the height tolerance of an item in the bin
+			if (curZ >= binZ + binH && curZ - (binZ + binH) <= LayerHeightTolerance)
 			{
-				int binX, binY, binZ, binW, binD, binH;
-				binX = this->itemXCoords[binIt];
-				binY = this->itemYCoords[binIt];
-				binZ = this->itemZCoords[binIt];
-				binW = this->itemWidths[binIt];
-				binD = this->itemDepths[binIt];
-				binH = this->itemHeights[binIt];
-
-				bool overlapFeasible = false;
-
-				//Check if the placed item does NOT overlap with the current item in the bin
-				if (curX + curW <= binX) overlapFeasible = true;		//Left
-				else if (curY + curD <= binY) overlapFeasible = true;	//Front
-				else if (curZ + curH <= binZ) overlapFeasible = true;	//Bottom
-				else if (curX >= binX + binW) overlapFeasible = true;	//Right
-				else if (curY >= binY + binD) overlapFeasible = true;	//Back
-				else if (curZ >= binZ + binH) overlapFeasible = true;	//Top
-
-				//If there is overlap, return false
-				if (overlapFeasible == false)
-					return false;
-
-				//If the placement is in the height tolerance of an item in the bin
-				if (curZ >= binZ + binH && curZ - (binZ + binH) <= LayerHeightTolerance)
-				{
-					//Calculate their width-depth overlap
-					double overlap = calculateOverlap(binX, binY, binW, binD, curX, curY, curW, curD, uniqueItemList[this->itemList[binIt]].supportType, uniqueItemList[this->itemList[binIt]].edgeReduceWidth, uniqueItemList[this->itemList[binIt]].edgeReduceDepth);
-
-					if (overlap == 0) continue;
+				const Item &binItem = items[this->itemList[binIt]];
 
-					//Set corner support values
-					if (curX >= binX && curX <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[0] = 1;
-					if (curX >= binX && curX <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[1] = 1;
-					if (curX + curW >= binX && curX + curW <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[2] = 1;
-					if (curX + curW >= binX && curX + curW <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[3] = 1;
+				//Calculate their width-depth overlap
+				double overlap = binItem.supportOverlap(binX, binY, binW, binD, curX, curY, curW, curD);
 
-					//Set up support(overlap) values so that weight distribution can be calculated
-					supportAreas.push_back(overlap);
-					totalOverlap += overlap;
-					supportedItems.push_back(this->itemList[binIt]);
-				}
-			}//for (int binIt = 0; binIt < itemWidths.size(); binIt++)
+				if (overlap == 0) continue;
 
+				//Set corner support values
+				if (curX >= binX && curX <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[0] = 1;
+				if (curX >= binX && curX <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[1] = 1;
+				if (curX + curW >= binX && curX + curW <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[2] = 1;
+				if (curX + curW >= binX && curX + curW <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[3] = 1;
 
-			//Check vertical support
-			if ((cornerSupport[0] == 0 || cornerSupport[1] == 0 || cornerSupport[2] == 0 || cornerSupport[3] == 0))
-			{
-				if ((double)100 * totalOverlap / (curW * curD) < itemSupportPercentage)
-				{
-					infAreaSupport++;
-					return false;	//If all the corners are not supported, and the support limit is not satisfied, return false
-				}
-			}
-			else if ((double)100 * totalOverlap / (curW * curD) < (double)100 * (4 * edgeSupportThickness * edgeSupportThickness) / (curW * curD))
-			{
-				inf4CSupport++;
-				return false;	//If all the corners are supported, decrease the support limit
+				//Set up support(overlap) values so that weight distribution can be calculated
+				supportAreas.push_back(overlap);
+				support.totalOverlap += overlap;
+				support.supportedItems.push_back(this->itemList[binIt]);
 			}
+		}//for (int binIt = 0; binIt < itemWidths.size(); binIt++)
+
+		//If the item is placed at the bottom of a bin, vertical support and load cap checks are not needed
+		if (curZ == 0)
+			return PLACEMENT_FEASIBLE;
+
+		//Check vertical support
+		if ((cornerSupport[0] == 0 || cornerSupport[1] == 0 || cornerSupport[2] == 0 || cornerSupport[3] == 0))
+		{
+			if ((double)100 * support.totalOverlap / (curW * curD) < itemSupportPercentage)
+				return PLACEMENT_AREA_SUPPORT;	//If all the corners are not supported, and the support limit is not satisfied, the placement is infeasible
+		}
+		else if ((double)100 * support.totalOverlap / (curW * curD) < (double)100 * (4 * edgeSupportThickness * edgeSupportThickness) / (curW * curD))
+			return PLACEMENT_CORNER_SUPPORT;	//If all the corners are supported, decrease the support limit
 
+		if (loadCapToggle == 1)
+		{
 			//Set up queues for BFS implementation, for weight distribution for load cap check
 			queue<int> iteratorList;
 			queue<double> weightList;
 
-			if (loadCapToggle == 1)
+			//Calculate weight distribution of the current item to all the items that support it in the bin
+			for (int j = 0; j < support.supportedItems.size(); j++)
 			{
-				//Calculate weight distribution of the current item to all the items that support it in the bin
-				for (int j = 0; j < supportedItems.size(); j++)
-				{
-					supportPercentages.push_back((double)supportAreas[j] / totalOverlap);
-					iteratorList.push(supportedItems[j]);
-					weightList.push(i.weight * supportPercentages.back());
-				}
+				support.supportPercentages.push_back((double)supportAreas[j] / support.totalOverlap);
+				iteratorList.push(support.supportedItems[j]);
+				weightList.push(i.weight * support.supportPercentages.back());
+			}
 
-				//Update the total weights on items through a BFS
-				while (iteratorList.size() > 0)
-				{
-					int curItem = iteratorList.front();
-					iteratorList.pop();
-					cpyUnique[curItem].totalSupportedWeight += weightList.front();
+			//Collect the additional weights on items through a BFS, without changing the item list
+			while (iteratorList.size() > 0)
+			{
+				int curItem = iteratorList.front();
+				iteratorList.pop();
 
-					if (cpyUnique[curItem].totalSupportedWeight > cpyUnique[curItem].loadCap)
-					{
-						feasibilityFlag = true;
-						infLoadBearing++;
-						break;
-					}
+				int loadIndex = find(support.loadedItems.begin(), support.loadedItems.end(), curItem) - support.loadedItems.begin();
+				if (loadIndex == support.loadedItems.size())
+				{
+					support.loadedItems.push_back(curItem);
+					support.addedWeights.push_back(0);
+				}
+				support.addedWeights[loadIndex] += weightList.front();
 
-					for (int j = 0; j < cpyUnique[curItem].supportedItems.size(); j++)
-					{
-						iteratorList.push(cpyUnique[curItem].supportedItems[j]);
-						weightList.push(cpyUnique[curItem].supportPercentages[j] * weightList.front());
-					}
+				if (items[curItem].totalSupportedWeight + support.addedWeights[loadIndex] > items[curItem].loadCap)
+					return PLACEMENT_LOAD_BEARING;
 
-					weightList.pop();
+				for (int j = 0; j < items[curItem].supportedItems.size(); j++)
+				{
+					iteratorList.push(items[curItem].supportedItems[j]);
+					weightList.push(items[curItem].supportPercentages[j] * weightList.front());
 				}
-			}
-			//If not infeasible, make uniqueItemList = copied list and update the current item's support info in it, if infeasible, return false
-			if (feasibilityFlag == true)
-			{
-				cpyUnique.clear();
-				iteratorList.empty();
-				weightList.empty();
-				supportingItems.clear();
-				supportedItems.clear();
-				supportAreas.clear();
-				supportPercentages.clear();
-				return false;
-			}
 
-			cpyUnique[i.ID].supportedItems = supportedItems;
-			cpyUnique[i.ID].supportPercentages = supportPercentages;
-
-			return true;
-		}
-		else
-		{
-			//If the item is placed at the bottom of a bin, vertical support and load cap checks are not needed
-			for (int binIt = 0; binIt < itemWidths.size(); binIt++)
-			{
-				int binX, binY, binZ, binW, binD, binH;
-				binX = this->itemXCoords[binIt];
-				binY = this->itemYCoords[binIt];
-				binZ = this->itemZCoords[binIt];
-				binW = this->itemWidths[binIt];
-				binD = this->itemDepths[binIt];
-				binH = this->itemHeights[binIt];
-
-				bool overlapFeasible = false;
-
-				//Check if the placed item does NOT overlap with the current item in the bin
-				if (curX + curW <= binX) overlapFeasible = true;		//Left
-				else if (curY + curD <= binY) overlapFeasible = true;	//Front
-				else if (curZ + curH <= binZ) overlapFeasible = true;	//Bottom
-				else if (curX >= binX + binW) overlapFeasible = true;	//Right
-				else if (curY >= binY + binD) overlapFeasible = true;	//Back
-				else if (curZ >= binZ + binH) overlapFeasible = true;	//Top
-
-				if (overlapFeasible == false) return false;
-			}//for (int binIt = 0; binIt < itemWidths.size(); binIt++)
-
-			return true;
+				weightList.pop();
+			}
 		}
+
+		return PLACEMENT_FEASIBLE;
 	}
 
 	/**
@@ -380,15 +533,104 @@ struct Bin
 		this->layerHeight = height;
 	}
 
+	/**
+	Shrink the free space of an extreme point with an item in the bin. For every corner, the free width and depth are measured along the lines
+	that an item placed at that corner covers, and the free height above the cell next to the extreme point. Any item longer than the free space
+	along one of these lines overlaps with an item in the bin.
+	@param an extreme point, and the x, y, z coordinates (front bottom left corner) and width, depth, height dimensions of the item in the bin
+	*/
+	void shrinkEPSpace(extremePoint &EP, int x, int y, int z, int width, int depth, int height) const
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			bool right = (c == 0 || c == 1);	//The item extends in the positive x direction
+			bool back = (c == 0 || c == 2);		//The item extends in the positive y direction
+			int lineX = right ? EP.x : EP.x - 1;
+			int lineY = back ? EP.y : EP.y - 1;
+
+			//Free width along the line at the depth of the item
+			if (y <= lineY && lineY < y + depth && z <= EP.z && EP.z < z + height)
+			{
+				if (right && x + width > EP.x)
+					EP.freeW[c] = min(EP.freeW[c], max(0, x - EP.x));
+				else if (!right && x < EP.x)
+					EP.freeW[c] = min(EP.freeW[c], max(0, EP.x - (x + width)));
+			}
+
+			//Free depth along the line at the width of the item
+			if (x <= lineX && lineX < x + width && z <= EP.z && EP.z < z + height)
+			{
+				if (back && y + depth > EP.y)
+					EP.freeD[c] = min(EP.freeD[c], max(0, y - EP.y));
+				else if (!back && y < EP.y)
+					EP.freeD[c] = min(EP.freeD[c], max(0, EP.y - (y + depth)));
+			}
+
+			//Free height above the cell next to the extreme point
+			if (x <= lineX && lineX < x + width && y <= lineY && lineY < y + depth && z + height > EP.z)
+				EP.freeH[c] = min(EP.freeH[c], max(0, z - EP.z));
+		}
+
+		EP.updateMaxFreeSpace();
+	}
+
+	/**
+	Calculate the free space of an extreme point from the bounds of the bin and all the items in the bin
+	@param an extreme point
+	*/
+	void setEPSpace(extremePoint &EP) const
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			EP.freeW[c] = (c == 0 || c == 1) ? BinWidth - EP.x : EP.x;
+			EP.freeD[c] = (c == 0 || c == 2) ? BinDepth - EP.y : EP.y;
+			EP.freeH[c] = BinHeight - EP.z;
+		}
+
+		EP.updateMaxFreeSpace();
+
+		for (int i = 0; i < this->itemWidths.size(); i++)
+		{
+			shrinkEPSpace(EP, this->itemXCoords[i], this->itemYCoords[i], this->itemZCoords[i], this->itemWidths[i], this->itemDepths[i], this->itemHeights[i]);
+		}
+
+		EP.spaceSet = true;
+	}
+
+	/**
+	Calculate the free space of the extreme points that do not have it yet
+	*/
+	void setEPSpaces()
+	{
+		for (int i = 0; i < this->epList.size(); i++)
+		{
+			if (this->epList[i].spaceSet == false)
+				setEPSpace(this->epList[i]);
+		}
+	}
+
+	/**
+	Shrink the free space of the extreme points that have it with a newly placed item, so that it is maintained incrementally
+	@param the x, y, z coordinates (front bottom left corner) and width, depth, height dimensions of the new item
+	*/
+	void updateEPSpace(int x, int y, int z, int width, int depth, int height)
+	{
+		for (int i = 0; i < this->epList.size(); i++)
+		{
+			if (this->epList[i].spaceSet == true)
+				shrinkEPSpace(this->epList[i], x, y, z, width, depth, height);
+		}
+	}
+
 	/**
 	Place items in a layer to the bin
-	@param a layer object
+	@param a layer object and the unique item list that keeps the support information of the placed items
 	*/
-	void unpackLayer(Layer &curLayer)
+	void unpackLayer(Layer &curLayer, vector<Item> &items)
 	{
 		int x, y, z, w, d, h;
 
-		for (int i = 0; i < curLayer.itemList.size(); i++)
+		for (int i = 0; i < curLayer.nbItems(); i++)
 		{
 			x = curLayer.xVec[i];
 			y = curLayer.yVec[i];
@@ -397,7 +639,7 @@ struct Bin
 			d = curLayer.dList[i];
 			h = curLayer.hList[i];
 			this->insertItemFromLayer(w, d, h, x, y, z);
-			this->itemList.push_back(curLayer.itemList[i].ID);
+			this->itemList.push_back(curLayer.item(i).ID);
 		}
 
 		if (this->height == 0)
@@ -415,13 +657,13 @@ struct Bin
 						int x1 = this->itemXCoords[j]; int y1 = this->itemYCoords[j]; int w1 = this->itemWidths[j]; int d1 = this->itemDepths[j];
 						int x2 = this->itemXCoords[i]; int y2 = this->itemYCoords[i]; int w2 = this->itemWidths[i]; int d2 = this->itemDepths[i];
 
-						double overlap = calculateOverlap(x1, y1, w1, d1, x2, y2, w2, d2, uniqueItemList[this->itemList[j]].supportType, uniqueItemList[this->itemList[j]].edgeReduceWidth, uniqueItemList[this->itemList[j]].edgeReduceDepth);
+						double overlap = items[this->itemList[j]].supportOverlap(x1, y1, w1, d1, x2, y2, w2, d2);
 
 						if (overlap == 0)
 							continue;
 
-						uniqueItemList[this->itemList[i]].supportedItems.push_back(this->itemList[j]);
-						uniqueItemList[this->itemList[i]].supportPercentages.push_back(overlap);
+						items[this->itemList[i]].supportedItems.push_back(this->itemList[j]);
+						items[this->itemList[i]].supportPercentages.push_back(overlap);
 					}
 				}
 			}
@@ -429,13 +671,13 @@ struct Bin
 			for (int i = 0; i < this->itemList.size(); i++)
 			{
 				double totalSupport = 0;
-				for (int j = 0; j < uniqueItemList[this->itemList[i]].supportPercentages.size(); j++)
+				for (int j = 0; j < items[this->itemList[i]].supportPercentages.size(); j++)
 				{
-					totalSupport += uniqueItemList[this->itemList[i]].supportPercentages[j];
+					totalSupport += items[this->itemList[i]].supportPercentages[j];
 				}
-				for (int j = 0; j < uniqueItemList[this->itemList[i]].supportPercentages.size(); j++)
+				for (int j = 0; j < items[this->itemList[i]].supportPercentages.size(); j++)
 				{
-					uniqueItemList[this->itemList[i]].supportPercentages[j] /= totalSupport;
+					items[this->itemList[i]].supportPercentages[j] /= totalSupport;
 				}
 			}
 		}//if (this->height == 0)
@@ -445,22 +687,40 @@ struct Bin
 //List of bins
 vector<Bin> binList;
 
+//Receiver of the final bins of the solution, called with the index of the bin in binList and the bin
+typedef function<void(int, const Bin&)> BinSink;
+BinSink binSink;
+
+/**
+Add a bin to the solution once its leftover items are placed, nothing is placed in it by the later batches
+Without the local search the bin is final, so it is passed to the bin sink right away. The bins reach the sink
+in the order of binList, so with planogram sequencing a bin only follows the bins with the earlier sequence numbers
+@param the bin, moved into binList
+*/
+void closeBin(Bin &bin)
+{
+	bin.epList.clear();
+	binList.push_back(std::move(bin));
+	if (binSink && localSearchTimeLimit == 0)
+		binSink(binList.size() - 1, binList.back());
+}
+
 /**
 Check if at least one item in a layer is placed before
 @param a list that tracks the already placed items, a layer object
 @return true if the layer has at least one item that is placed before
 */
-bool isItCovered(vector<int> coveredItems, Layer curLayer)
+bool isItCovered(const vector<int> &coveredItems, const Layer &curLayer)
 {
 	bool coveredFlag = false;
 
 	//Check if the layer has any previously covered items
-	for (int j = 0; j < curLayer.itemList.size(); j++)
+	for (int j = 0; j < curLayer.nbItems(); j++)
 	{
 		//If it is a normal item
-		if (curLayer.itemList[j].SIList.size() == 0)
+		if (curLayer.item(j).SIList.size() == 0)
 		{
-			if (coveredItems[curLayer.itemList[j].ID] == 1)
+			if (coveredItems[curLayer.item(j).ID] == 1)
 			{
 				coveredFlag = true;
 				break;
@@ -471,9 +731,9 @@ bool isItCovered(vector<int> coveredItems, Layer curLayer)
 		{
 			//Loop through items in the super-item
 			bool secondCoveredFlag = false;
-			for (int k = 0; k < curLayer.itemList[j].SIList.size(); k++)
+			for (int k = 0; k < curLayer.item(j).SIList.size(); k++)
 			{
-				if (coveredItems[curLayer.itemList[j].SIList[k].ID] == 1)
+				if (coveredItems[curLayer.item(j).SIList[k].ID] == 1)
 				{
 					coveredFlag = true;
 					secondCoveredFlag = true;
@@ -490,12 +750,12 @@ bool isItCovered(vector<int> coveredItems, Layer curLayer)
 void removeCoveredItems(vector<int> &coveredItems, Layer &curLayer) 
 {
 	//Check if the layer has any previously covered items
-	for (int j = 0; j < curLayer.itemList.size(); j++)
+	for (int j = 0; j < curLayer.nbItems(); j++)
 	{
 		//If it is a normal item
-		if (curLayer.itemList[j].SIList.size() == 0)
+		if (curLayer.item(j).SIList.size() == 0)
 		{
-			if (coveredItems[curLayer.itemList[j].ID] == 1)
+			if (coveredItems[curLayer.item(j).ID] == 1)
 			{
 				curLayer.deleteItem(j);
 				j--;
@@ -506,9 +766,9 @@ void removeCoveredItems(vector<int> &coveredItems, Layer &curLayer)
 		{
 			//Loop through items in the super-item
 			bool secondCoveredFlag = false;
-			for (int k = 0; k < curLayer.itemList[j].SIList.size(); k++)
+			for (int k = 0; k < curLayer.item(j).SIList.size(); k++)
 			{
-				if (coveredItems[curLayer.itemList[j].SIList[k].ID] == 1)
+				if (coveredItems[curLayer.item(j).SIList[k].ID] == 1)
 				{
 					curLayer.deleteItem(j);
 					j--;
@@ -523,11 +783,11 @@ void removeCoveredItems(vector<int> &coveredItems, Layer &curLayer)
 Update the placed item tracker after a layer is placed in a bin
 @param a list that tracks the already placed items, a layer object
 */
-void updateCoveredList(vector<int> &coveredItems, Layer curLayer)
+void updateCoveredList(vector<int> &coveredItems, const Layer &curLayer)
 {
-	for (int i = 0; i < curLayer.itemList.size(); i++)
+	for (int i = 0; i < curLayer.nbItems(); i++)
 	{
-		Item curItem = curLayer.itemList[i];
+		Item curItem = curLayer.item(i);
 
 		if (curItem.SIList.size() == 0)
 			coveredItems[curItem.ID] = 1;
@@ -552,12 +812,193 @@ double calculateMerit(int x, int y, int z, int height, int width, int depth, int
 	//return 1000000 * (1 + (double)(BinHeight - z) / (BinHeight)) * (1 + ((double)(width * depth) / (BinWidth * BinDepth))) * (1 + loadCap / maxLoadCap) + 100 * (1 + (double)(BinDepth - y) / (BinDepth)) + 10 * (1 + (double)(BinWidth - x) / (BinWidth));
 }
 
+//Candidate placement of a leftover item
+struct PlacementCandidate
+{
+	int itemIndex, epIndex, orientation, corner;	//Position of the candidate in the scan order of placeLeftovers
+	int z;											//Height of the bottom of the item
+	double contact;									//Share of the bottom face of the item that is supported
+};
+
 /**
-Place the remaining items after all possible layers are placed into a bin
-@param a bin object, a list of remaining items
+Sortation rule for candidate placements: lower placements first, then placements with more contact, then the scan order of placeLeftovers
+@param two candidate placements
+@return true if the first candidate is better
 */
-void placeLeftovers(Bin &bin, vector<Item> &leftovers)
+bool betterPlacement(const PlacementCandidate &p1, const PlacementCandidate &p2)
+{
+	if (p1.z != p2.z)
+		return p1.z < p2.z;
+	else if (p1.contact != p2.contact)
+		return p1.contact > p2.contact;
+	else if (p1.itemIndex != p2.itemIndex)
+		return p1.itemIndex < p2.itemIndex;
+	else if (p1.epIndex != p2.epIndex)
+		return p1.epIndex < p2.epIndex;
+	else if (p1.orientation != p2.orientation)
+		return p1.orientation < p2.orientation;
+	else
+		return p1.corner > p2.corner;
+}
+
+/**
+Find the best feasible placement of a leftover item in a bin. Candidates are checked in parallel on the read-only bin state,
+and the result does not depend on the number of threads.
+@param a bin object with a sorted extreme point list, a list of remaining items, the item list with the current support information,
+the infeasibility counts indexed by the placement results, and the candidate to be set
+@return true if a feasible placement is found
+*/
+bool findBestPlacement(const Bin &bin, const vector<Item> &leftovers, const vector<Item> &items, int *infeasibility, PlacementCandidate &best)
+{
+	int nbEPs = bin.epList.size();
+	int nbCandidates = leftovers.size() * nbEPs;
+
+	if (nbCandidates == 0)
+		return false;
+
+	//Split the item-extreme point pairs into chunks in scan order, and find the best candidate of every chunk
+	ThreadPool &pool = getThreadPool();
+	int nbChunks = min(nbCandidates, pool.size() * 8);
+	vector<PlacementCandidate> chunkBest(nbChunks);
+	vector<int> chunkFound(nbChunks, 0);
+	vector<int> chunkInfeasibility(nbChunks * 6, 0);
+
+	pool.parallelFor(nbChunks, [&](int chunk)
+	{
+		int start = (long long)nbCandidates * chunk / nbChunks;
+		int end = (long long)nbCandidates * (chunk + 1) / nbChunks;
+		PlacementSupport support;
+
+		for (int k = start; k < end; k++)
+		{
+			int i = k / nbEPs;
+			int j = k % nbEPs;
+			const Item &curItem = leftovers[i];
+			const extremePoint &curEP = bin.epList[j];
+
+			//Extreme points are sorted by height, and no placement at a higher extreme point can be better
+			if (chunkFound[chunk] == 1 && curEP.z > chunkBest[chunk].z)
+				continue;
+
+			if (!curEP.fitsAny(min(curItem.w, curItem.d), max(curItem.w, curItem.d), curItem.h))
+				continue;
+
+			//Collect the orientation and corner combinations that fit into the free space, which also covers the bounds of the bin
+			int nbBoxes = 0;
+			int boxX[8], boxY[8], boxZ[8], boxW[8], boxD[8], boxH[8], boxOrientation[8], boxCorner[8];
+			char collides[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+			for (int o = 0; o < 2; o++)
+			{
+				int curW = o == 0 ? curItem.w : curItem.d;
+				int curD = o == 0 ? curItem.d : curItem.w;
+
+				for (int c = 3; c >= 0; c--)
+				{
+					if (!curEP.fits(curW, curD, curItem.h, c))
+						continue;
+
+					cornerOrigin(curEP, curW, curD, c, boxX[nbBoxes], boxY[nbBoxes]);
+					boxZ[nbBoxes] = curEP.z;
+					boxW[nbBoxes] = curW;
+					boxD[nbBoxes] = curD;
+					boxH[nbBoxes] = curItem.h;
+					boxOrientation[nbBoxes] = o;
+					boxCorner[nbBoxes] = c;
+					nbBoxes++;
+				}
+			}
+
+			//The bin weight rejects all the combinations, before the collision check as in evaluatePlacement
+			if (bin.weight + curItem.weight > maxBinWeight)
+			{
+				chunkInfeasibility[chunk * 6 + PLACEMENT_BIN_WEIGHT] += nbBoxes;
+				continue;
+			}
+
+			//Reject the colliding combinations in one batch
+			bin.testCollisions(nbBoxes, boxX, boxY, boxZ, boxW, boxD, boxH, collides);
+
+			//Try the combinations in scan order, their bin weight and collisions are checked
+			for (int box = 0; box < nbBoxes; box++)
+			{
+				if (collides[box] == 1)
+				{
+					chunkInfeasibility[chunk * 6 + PLACEMENT_OVERLAP]++;
+					continue;
+				}
+
+				int result = bin.evaluateSupport(curEP, curItem, boxW[box], boxD[box], curItem.h, boxCorner[box], items, support);
+				if (result != PLACEMENT_FEASIBLE)
+				{
+					chunkInfeasibility[chunk * 6 + result]++;
+					continue;
+				}
+
+				PlacementCandidate candidate;
+				candidate.itemIndex = i;
+				candidate.epIndex = j;
+				candidate.orientation = boxOrientation[box];
+				candidate.corner = boxCorner[box];
+				candidate.z = curEP.z;
+				candidate.contact = curEP.z == 0 ? 1.0 : support.totalOverlap / (boxW[box] * boxD[box]);
+
+				if (chunkFound[chunk] == 0 || betterPlacement(candidate, chunkBest[chunk]))
+				{
+					chunkBest[chunk] = candidate;
+					chunkFound[chunk] = 1;
+				}
+			}
+		}
+	});
+
+	//Merge the chunk results in order
+	bool found = false;
+	for (int chunk = 0; chunk < nbChunks; chunk++)
+	{
+		for (int result = 1; result < 6; result++)
+		{
+			infeasibility[result] += chunkInfeasibility[chunk * 6 + result];
+		}
+
+		if (chunkFound[chunk] == 1 && (found == false || betterPlacement(chunkBest[chunk], best)))
+		{
+			best = chunkBest[chunk];
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/**
+Check the placement of a leftover item against an item list, and count the reason of an infeasibility
+@param a bin object, an extreme point, an item object in its orientation, the corner of the item placed at the extreme point, the item list with the current support information,
+the infeasibility counts indexed by the placement results, and the item list the support information of a feasible placement is written to
+@return true if the item can be feasibly placed in the bin
+*/
+bool tryPlacement(const Bin &bin, const extremePoint &EP, const Item &i, int corner, const vector<Item> &items, int *infeasibility, vector<Item> &placedItems)
+{
+	PlacementSupport support;
+	int result = bin.evaluatePlacement(EP, i, i.w, i.d, i.h, corner, items, support);
+	infeasibility[result]++;
+
+	if (result != PLACEMENT_FEASIBLE)
+		return false;
+
+	placedItems = items;
+	if (support.z > 0)
+		applyPlacementSupport(placedItems, i.ID, support);
+
+	return true;
+}
+
+/**
+Place the remaining items after all possible layers are placed into a bin, without touching the global item lists and counters, so that trial placements can run in parallel on copies
+@param a bin object, a list of remaining items, the item list with the current support information, and the infeasibility counts indexed by the placement results
+*/
+void placeLeftovers(Bin &bin, vector<Item> &leftovers, vector<Item> &items, int *infeasibility)
 {
+	PROFILE_SCOPE("placeLeftovers");
 	//Main item loop for placement
 	sort(leftovers.begin(), leftovers.end(), &sortItemsHorizontalArea);
 	bin.initiateEPList();
@@ -570,23 +1011,85 @@ void placeLeftovers(Bin &bin, vector<Item> &leftovers)
 	//Loop as long as there are items to be placed
 	while (leftovers.size() > 0)
 	{
+		//Calculate the free space of new extreme points
+		bin.setEPSpaces();
+
+		//Get the smallest dimensions among the leftover items
+		int minShortSide = BinWidth + BinDepth;
+		int minLongSide = BinWidth + BinDepth;
+		int minHeight = BinHeight;
+		for (int i = 0; i < leftovers.size(); i++)
+		{
+			minShortSide = min(minShortSide, min(leftovers[i].w, leftovers[i].d));
+			minLongSide = min(minLongSide, max(leftovers[i].w, leftovers[i].d));
+			minHeight = min(minHeight, leftovers[i].h);
+		}
+
+		//Remove the extreme points that cannot take any of the leftover items. Free space only shrinks, so they cannot be used later either.
+		//The first feasible scan turns the item once for every extreme point, so removing extreme points would change the order it tries the orientations in
+		for (int ep = bin.epList.size() - 1; ep >= 0 && leftoverPlacementMode == 1; ep--)
+		{
+			if (!bin.epList[ep].fitsAny(minShortSide, minLongSide, minHeight))
+			{
+				extremePoint tempEP = bin.epList.back();
+				bin.epList.back() = bin.epList[ep];
+				bin.epList[ep] = tempEP;
+				bin.epList.pop_back();
+			}
+		}
+
 		//Sort extreme points based on the sortEP sortation rule
 		sort(bin.epList.begin(), bin.epList.end(), &sortEP);
 		bool itemPlaced = false;	//Flag for checking if any item has been placed
 		int bestX, bestY, bestZ;
 		Item bestItem;
 		int bestIndex = -1;
-		vector<Item> bestCopyItemList = uniqueItemList;
+		vector<Item> bestCopyItemList;
 
-		for (int i = 0; i < leftovers.size(); i++)
+		//Evaluate all item, extreme point, orientation and corner combinations in parallel, and place the best one
+		if (leftoverPlacementMode == 1)
+		{
+			PlacementCandidate best;
+			if (findBestPlacement(bin, leftovers, items, infeasibility, best))
+			{
+				extremePoint bestEP = bin.epList[best.epIndex];
+				bestItem = leftovers[best.itemIndex];
+				if (best.orientation == 1)
+					bestItem.rotateItem();
+
+				//Repeat the check on the bin to get the updated copy of the item list
+				if (tryPlacement(bin, bestEP, bestItem, best.corner, items, infeasibility, bestCopyItemList))
+				{
+					itemPlaced = true;
+					cornerOrigin(bestEP, bestItem.w, bestItem.d, best.corner, bestX, bestY);
+					bestZ = bestEP.z;
+					bestIndex = best.itemIndex;
+				}
+			}
+		}
+
+		for (int i = 0; i < leftovers.size() && leftoverPlacementMode == 0; i++)
 		{
 			Item curItem = leftovers[i];
+			int shortSide = min(curItem.w, curItem.d);
+			int longSide = max(curItem.w, curItem.d);
+
+			//Items over the bin weight limit are not pruned, so that every combination is counted as a bin weight infeasibility as without the pruning
+			bool prune = bin.weight + curItem.weight <= maxBinWeight;
 			
 			//Loop through all the extreme points
 			for (int j = 0; j < bin.epList.size(); j++)
 			{
 				extremePoint curEP = bin.epList[j];
 
+				//If the item does not fit into the free space of the extreme point in any way, go to next extreme point
+				//The item is turned once for every extreme point, so that the orientations are tried in the same order as without the check
+				if (prune && !curEP.fitsAny(shortSide, longSide, curItem.h))
+				{
+					curItem.rotateItem();
+					continue;
+				}
+
 				//Try both orientations of the item
 				for (int o = 0; o < 2; o++)
 				{
@@ -619,8 +1122,12 @@ void placeLeftovers(Bin &bin, vector<Item> &leftovers)
 
 
 						}
+						//If the item does not fit into the free space at this corner, it overlaps with an item in the bin
+						if (prune && !curEP.fits(curItem.w, curItem.d, curItem.h, c))
+							continue;
+
 						//Check if the placement is feasible
-						if (bin.checkFeasibility(curEP, curItem, curItem.w, curItem.d, curItem.h, c))
+						if (tryPlacement(bin, curEP, curItem, c, items, infeasibility, bestCopyItemList))
 						{
 							itemPlaced = true;
 							//double merit = calculateMerit(curEP.x, curEP.y, curEP.z, curItem.h, curItem.w, curItem.d, curItem.planogramSeq, curItem.loadCap);							
@@ -642,8 +1149,6 @@ void placeLeftovers(Bin &bin, vector<Item> &leftovers)
 								bestX = curEP.x - curItem.w; bestY = curEP.y - curItem.d; bestZ = curEP.z;
 							}
 							bestIndex = i;
-							bestCopyItemList = cpyUnique;
-							cpyUnique.clear();
 
 							//Since both the items and the extreme points are sorted properly, we can exit the loop if there is a feasible placement
 							//This guarantees that the first feasible placement provides the maximum merit function value regardless
@@ -669,10 +1174,9 @@ void placeLeftovers(Bin &bin, vector<Item> &leftovers)
 		{
 			bin.insertItemAtEP(bestItem.w, bestItem.d, bestItem.h, bestX, bestY, bestZ, bestItem.ID);
 			leftovers.erase(leftovers.begin() + bestIndex);
-			std::cout << "Leftover size is: " << leftovers.size() << endl;
-			coveredList[bestItem.ID] = 1;
-			uniqueItemList = bestCopyItemList;
-			bestCopyItemList.clear();
+			if (leftoverLogToggle == 1)
+				std::cout << "Leftover size is: " << leftovers.size() << endl;
+			items.swap(bestCopyItemList);
 
 			if (bestZ >= layerHeight)
 			{
@@ -691,16 +1195,47 @@ void placeLeftovers(Bin &bin, vector<Item> &leftovers)
 	}//while (leftovers.size() > 0)
 }
 
+/**
+Place the remaining items after all possible layers are placed into a bin
+@param a bin object, a list of remaining items
+*/
+void placeLeftovers(Bin &bin, vector<Item> &leftovers)
+{
+	int infeasibility[6] = { 0, 0, 0, 0, 0, 0 };
+	int nbPlaced = bin.itemList.size();
+	placeLeftovers(bin, leftovers, uniqueItemList, infeasibility);
+
+	for (int i = nbPlaced; i < bin.itemList.size(); i++)
+		coveredList[bin.itemList[i]] = 1;
+	for (int result = 1; result < 6; result++)
+		countInfeasibility(result, infeasibility[result]);
+}
+
 /**
 Check the feasibility of placing a layer on top of the layers in a bin based on toggled practical constraints and overlaps
 NOTE: Implementation of this function is similar to the feasibility check in the bin class definition, refer to that one
-@param a layer object to be placed, and a bin object
+@param a layer object to be placed, a bin object, and the unique item list that gets the support information of the layer if the placement is feasible
 @return true if the placement is feasible
 */
-bool layerFeasibility(const Layer &topLayer, const Bin &currentBin)
+bool layerFeasibility(const Layer &topLayer, const Bin &currentBin, vector<Item> &items)
 {
-	vector<Item> copyItemList = uniqueItemList;
-	for (int i = topLayer.itemList.size() - 1; i >= 0; i--)
+	PROFILE_SCOPE("layerFeasibility");
+	vector<Item> copyItemList = items;
+
+	//Support shapes of the items at the top of the bin, the overlaps of every layer item placed on them are computed in one batch
+	static thread_local SupportBatch topSupport;
+	vector<int> topItems;
+	topSupport.clear();
+	for (int j = 0; j < currentBin.itemWidths.size(); j++)
+	{
+		if (currentBin.height - (currentBin.itemZCoords[j] + currentBin.itemHeights[j]) <= LayerHeightTolerance)
+		{
+			topItems.push_back(j);
+			topSupport.add(items[currentBin.itemList[j]].placedSupportShape(currentBin.itemWidths[j], currentBin.itemDepths[j]), currentBin.itemXCoords[j], currentBin.itemYCoords[j]);
+		}
+	}
+
+	for (int i = topLayer.nbItems() - 1; i >= 0; i--)
 	{
 		bool feasibilityFlag = false;
 		vector<int> supportingItems;
@@ -708,7 +1243,7 @@ bool layerFeasibility(const Layer &topLayer, const Bin &currentBin)
 		vector<int> cornerSupport(4, 0);
 		vector<double> supportAreas;
 		vector<double> supportPercentages;
-		Item currentItem = topLayer.itemList[i];
+		Item currentItem = topLayer.item(i);
 		double totalOverlap = 0;
 		int curX, curY, curZ, curW, curD, curH;
 
@@ -721,34 +1256,33 @@ bool layerFeasibility(const Layer &topLayer, const Bin &currentBin)
 
 		if (curZ == 0)
 		{
-			for (int j = 0; j < currentBin.itemWidths.size(); j++)
+			supportOverlaps(topSupport, curX, curY, curW, curD);
+			for (int t = 0; t < topItems.size(); t++)
 			{
-				if (currentBin.height - (currentBin.itemZCoords[j] + currentBin.itemHeights[j]) <= LayerHeightTolerance)
-				{
-					int binX, binY, binW, binD;
-					binX = currentBin.itemXCoords[j];
-					binY = currentBin.itemYCoords[j];
-					binW = currentBin.itemWidths[j];
-					binD = currentBin.itemDepths[j];
+				int j = topItems[t];
+				int binX, binY, binW, binD;
+				binX = currentBin.itemXCoords[j];
+				binY = currentBin.itemYCoords[j];
+				binW = currentBin.itemWidths[j];
+				binD = currentBin.itemDepths[j];
 
-					double overlap = calculateOverlap(binX, binY, binW, binD, curX, curY, curW, curD, uniqueItemList[currentBin.itemList[j]].supportType, uniqueItemList[currentBin.itemList[j]].edgeReduceWidth, uniqueItemList[currentBin.itemList[j]].edgeReduceDepth);
+				double overlap = topSupport.overlaps[t];
 
-					if (overlap == 0) continue;
+				if (overlap == 0) continue;
 
-					if (curX >= binX && curX <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[0] = 1;
-					if (curX >= binX && curX <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[1] = 1;
-					if (curX + curW >= binX && curX + curW <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[2] = 1;
-					if (curX + curW >= binX && curX + curW <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[3] = 1;
+				if (curX >= binX && curX <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[0] = 1;
+				if (curX >= binX && curX <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[1] = 1;
+				if (curX + curW >= binX && curX + curW <= binX + binW && curY >= binY && curY <= binY + binD) cornerSupport[2] = 1;
+				if (curX + curW >= binX && curX + curW <= binX + binW && curY + curD >= binY && curY + curD <= binY + binD) cornerSupport[3] = 1;
 
-					supportAreas.push_back(overlap);
-					totalOverlap += overlap;
-					supportedItems.push_back(currentBin.itemList[j]);
-				}
+				supportAreas.push_back(overlap);
+				totalOverlap += overlap;
+				supportedItems.push_back(currentBin.itemList[j]);
 			}
 		}
 		else
 		{
-			for (int j = 0; j < topLayer.itemList.size() && topLayer.itemList[j].ID != currentItem.ID; j++)
+			for (int j = 0; j < topLayer.nbItems() && topLayer.item(j).ID != currentItem.ID; j++)
 			{
 				if (curZ - (topLayer.zVec[j] + topLayer.hList[j]) <= LayerHeightTolerance)
 				{
@@ -758,13 +1292,13 @@ bool layerFeasibility(const Layer &topLayer, const Bin &currentBin)
 					layerW = topLayer.wList[j];
 					layerD = topLayer.dList[j];
 
-					double overlap = calculateOverlap(layerX, layerY, layerW, layerD, curX, curY, curW, curD, topLayer.itemList[j].supportType, topLayer.itemList[j].edgeReduceWidth, topLayer.itemList[j].edgeReduceDepth);
+					double overlap = topLayer.item(j).supportOverlap(layerX, layerY, layerW, layerD, curX, curY, curW, curD);
 
 					if (overlap == 0) continue;
 
 					supportAreas.push_back(overlap);
 					totalOverlap += overlap;
-					supportedItems.push_back(topLayer.itemList[j].ID);
+					supportedItems.push_back(topLayer.item(j).ID);
 				}
 			}
 		}
@@ -812,7 +1346,7 @@ bool layerFeasibility(const Layer &topLayer, const Bin &currentBin)
 				weightList.pop();
 			}
 		}
-		//If not infeasible, make uniqueItemList = copied list and update the current item's support info in it, if infeasible, return false
+		//If not infeasible, make the item list = copied list and update the current item's support info in it, if infeasible, return false
 		
 		if (feasibilityFlag == true)
 		{
@@ -830,17 +1364,308 @@ bool layerFeasibility(const Layer &topLayer, const Bin &currentBin)
 		copyItemList[currentItem.ID].supportedItems = supportedItems;
 		copyItemList[currentItem.ID].supportPercentages = supportPercentages;
 	}
-	uniqueItemList = copyItemList;
+	items = copyItemList;
 	copyItemList.clear();
 
 	return true;
 }
 
+//Entry of the layer queue used in bin construction
+struct LayerQueueEntry
+{
+	bool selected;		//Layer selected by diving on the master LP
+	double score;		//Layer score (density for the default ordering) when the entry was pushed
+	int index;			//Index of the layer in layerList
+	int version;		//Number of times the layer was re-scored when the entry was pushed
+
+	LayerQueueEntry(bool selected, double score, int index, int version)
+	{
+		this->selected = selected;
+		this->score = score;
+		this->index = index;
+		this->version = version;
+	}
+
+	//Selected layers come first, then layers with larger scores, ties are broken by the position in the sorted layer list
+	bool operator< (const LayerQueueEntry &otherE) const
+	{
+		if (selected != otherE.selected)
+			return otherE.selected;
+		if (score != otherE.score)
+			return score < otherE.score;
+		return index > otherE.index;
+	}
+};
+
+/**
+Collect the IDs of the items in a layer, including the items inside super items
+@param a layer object and the list the IDs are added to
+*/
+void getLayerItemIDs(const Layer &curLayer, vector<int> &itemIDs)
+{
+	for (int i = 0; i < curLayer.nbItems(); i++)
+	{
+		if (curLayer.item(i).SIList.size() == 0)
+			itemIDs.push_back(curLayer.item(i).ID);
+		else
+		{
+			for (int j = 0; j < curLayer.item(i).SIList.size(); j++)
+				itemIDs.push_back(curLayer.item(i).SIList[j].ID);
+		}
+	}
+}
+
+//State of a bin construction pass, every pass works on its own copies so that passes can run in parallel
+struct BinConstructionPass
+{
+	int ordering;					//Layer ordering		0: Decreasing density		1: Density with a load cap bonus		2: Density with an LP value bonus		3+: Randomly perturbed density
+	vector<double> noise;			//Density perturbation of every layer for randomized orderings
+	vector<Layer> layers;			//Layers that are not placed, the remaining layers when the pass is over
+	vector<int> covered;			//Copy of the covered item list
+	vector<Item> items;				//Copy of the unique item list with the support information of the placed layers
+	vector<Bin> openBinList;		//Bins that still take layers
+	vector<Bin> newBinList;			//Bins that are full
+	double leftoverVolume;			//Volume of the batch items that are not covered when the pass is over
+	int nbUsedBins;					//Number of bins with layers when the pass is over
+};
+
+/**
+Calculate the queue score of a layer for the layer ordering of a pass
+@param a bin construction pass and the index of the layer in the pass
+@return the score, layers with larger scores are placed first
+*/
+double layerScore(const BinConstructionPass &pass, int index)
+{
+	const Layer &curLayer = pass.layers[index];
+
+	if (pass.ordering == 0)
+		return curLayer.layerOccupancy;
+
+	if (pass.ordering == 1)
+	{
+		//Up to 10% bonus for the average load cap, as in sortLayersLoadCap
+		double loadCap = 0;
+		for (int i = 0; i < curLayer.nbItems(); i++)
+			loadCap += curLayer.item(i).loadCap;
+		loadCap /= curLayer.nbItems();
+		return curLayer.layerOccupancy * (1 + 0.1 * loadCap / max(maxLoadCap, 1));
+	}
+
+	if (pass.ordering == 2)
+		return curLayer.layerOccupancy * (1 + curLayer.alpha);
+
+	return curLayer.layerOccupancy * (1 + pass.noise[index]);
+}
+
+/**
+Place the layers of a pass to its bins, densest (by the ordering of the pass) feasible layer first
+@param a bin construction pass with its layers, covered item list, item list and open bins set up
+*/
+void runBinConstructionPass(BinConstructionPass &pass)
+{
+	vector<Bin> &openBinList = pass.openBinList;
+	vector<Bin> &newBinList = pass.newBinList;
+
+	//Index the layers by the items they contain, so that only the layers with newly covered items are re-scored after a placement
+	vector<vector<int>> itemLayerIndex(pass.covered.size());
+	vector<int> layerVersion(pass.layers.size(), 0);
+	vector<bool> layerActive(pass.layers.size(), true);
+	vector<int> layerMark(pass.layers.size(), -1);
+	priority_queue<LayerQueueEntry> layerQueue;
+	vector<int> itemIDs;
+
+	for (int i = 0; i < pass.layers.size(); i++)
+	{
+		itemIDs.clear();
+		getLayerItemIDs(pass.layers[i], itemIDs);
+		for (int j = 0; j < itemIDs.size(); j++)
+			itemLayerIndex[itemIDs[j]].push_back(i);
+
+		layerQueue.push(LayerQueueEntry(pass.layers[i].alpha > 0.999, layerScore(pass, i), i, 0));
+	}
+
+	//Try to place as many layers as possible to the open bins
+	int placementCount = 0;
+	while (layerQueue.size() > 0)
+	{
+		int bestLayerIndex = -1;
+		int bestBinIndex = -1;
+		Layer bestLayer;
+		vector<LayerQueueEntry> scannedEntries;
+
+		//Find the first empty open bin
+		int emptyBinIndex = -1;
+		for (int j = 0; j < openBinList.size(); j++)
+		{
+			if (openBinList[j].binLayers.size() == 0)
+			{
+				emptyBinIndex = j;
+				break;
+			}
+		}
+
+		//Loop through layers in decreasing score
+		while (layerQueue.size() > 0)
+		{
+			LayerQueueEntry entry = layerQueue.top();
+			layerQueue.pop();
+
+			//Skip the entries of layers that were re-scored or removed after the entry was pushed
+			if (!layerActive[entry.index] || entry.version != layerVersion[entry.index])
+				continue;
+
+			scannedEntries.push_back(entry);
+			const Layer &queuedLayer = pass.layers[entry.index];
+
+			//Add the layer to the empty bin, in density order the remaining layers are not denser (apart from the unselected ones behind selected layers)
+			if (emptyBinIndex >= 0)
+			{
+				if (queuedLayer.layerOccupancy < 60.0)
+				{
+					if (entry.selected || pass.ordering != 0)
+						continue;
+					break;
+				}
+
+				Layer curLayer = queuedLayer;
+				//Space the layer
+				if (BinWidth > 700)
+					spaceLayer(curLayer);
+				curLayer.unpack();
+				openBinList[emptyBinIndex].binLayers.push_back(curLayer);
+				openBinList[emptyBinIndex].unpackLayer(curLayer, pass.items);
+				openBinList[emptyBinIndex].height += curLayer.layerHeight;
+				openBinList[emptyBinIndex].weight += curLayer.weight;
+				updateCoveredList(pass.covered, curLayer);
+				bestLayerIndex = -2;
+				bestLayer = curLayer;
+				break;
+			}
+
+			for (int j = 0; j < openBinList.size(); j++)
+			{
+				if (openBinList[j].weight + queuedLayer.weight > maxBinWeight)
+					break;
+
+				Layer curLayer = queuedLayer;
+				//Space the layer to maximize support
+				if (BinWidth > 700)
+					maximizeSupport(openBinList[j].binLayers.back(), curLayer);
+				curLayer.unpack();
+				//If the layer is 100% supported from the bottom, add the layer
+				if (layerFeasibility(curLayer, openBinList[j], pass.items))
+				{
+					bestLayerIndex = entry.index;
+					bestBinIndex = j;
+					bestLayer = curLayer;
+					break;
+				}
+			}//for (int j = 0; j < openBinList.size(); j++)
+			if (bestLayerIndex >= 0)
+				break;
+		}//while (layerQueue.size() > 0)
+
+		//Return the scanned layers to the queue, the placed layer is dropped when it is re-scored below
+		for (int i = 0; i < scannedEntries.size(); i++)
+			layerQueue.push(scannedEntries[i]);
+
+		if (bestLayerIndex >= 0)
+		{
+			openBinList[bestBinIndex].binLayers.push_back(bestLayer);
+			openBinList[bestBinIndex].unpackLayer(bestLayer, pass.items);
+
+			openBinList[bestBinIndex].height += bestLayer.layerHeight;
+			openBinList[bestBinIndex].weight += bestLayer.weight;
+			updateCoveredList(pass.covered, bestLayer);
+
+			//Add bin to the final bin list if it is full
+			if (openBinList[bestBinIndex].height > normalLayerHeight)
+			{
+				newBinList.push_back(openBinList[bestBinIndex]);
+				openBinList.erase(openBinList.begin() + bestBinIndex);
+			}
+		}
+
+		if (bestLayerIndex == -1)
+		{
+			//pass.layers.clear();
+			break;
+		}
+	
+		
+		if (openBinList.size() == 0)
+			break;
+
+		//Remove the newly covered items from the layers that contain them and re-score those layers
+		itemIDs.clear();
+		getLayerItemIDs(bestLayer, itemIDs);
+		for (int i = 0; i < itemIDs.size(); i++)
+		{
+			for (int k = 0; k < itemLayerIndex[itemIDs[i]].size(); k++)
+			{
+				int l = itemLayerIndex[itemIDs[i]][k];
+				if (!layerActive[l] || layerMark[l] == placementCount)
+					continue;
+				layerMark[l] = placementCount;
+
+				removeCoveredItems(pass.covered, pass.layers[l]);
+				pass.layers[l].calculateLayerOccupancy();
+				layerVersion[l]++;
+
+				//Remove layers with less than 40% density
+				if (pass.layers[l].layerOccupancy < 40.0)
+					layerActive[l] = false;
+				else
+					layerQueue.push(LayerQueueEntry(pass.layers[l].alpha > 0.999, layerScore(pass, l), l, layerVersion[l]));
+			}
+		}
+		placementCount++;
+	}//while (layerQueue.size() > 0)
+
+	//Keep the remaining layers in queue order
+	vector<Layer> remainingLayers;
+	while (layerQueue.size() > 0)
+	{
+		LayerQueueEntry entry = layerQueue.top();
+		layerQueue.pop();
+		if (layerActive[entry.index] && entry.version == layerVersion[entry.index])
+			remainingLayers.push_back(std::move(pass.layers[entry.index]));
+	}
+	pass.layers = remainingLayers;
+
+	pass.leftoverVolume = 0;
+	for (int i = 0; i < itemList.size(); i++)
+	{
+		if (pass.covered[itemList[i].ID] == 0)
+			pass.leftoverVolume += (double)itemList[i].w * itemList[i].d * itemList[i].h;
+	}
+
+	pass.nbUsedBins = newBinList.size();
+	for (int i = 0; i < openBinList.size(); i++)
+	{
+		if (openBinList[i].binLayers.size() > 0)
+			pass.nbUsedBins++;
+	}
+}
+
+/**
+Check if a bin construction pass is better than another one
+@param two bin construction passes that are over
+@return true if the first pass leaves less volume uncovered, or the same volume in fewer bins
+*/
+bool betterPass(const BinConstructionPass &p1, const BinConstructionPass &p2)
+{
+	if (p1.leftoverVolume != p2.leftoverVolume)
+		return p1.leftoverVolume < p2.leftoverVolume;
+	return p1.nbUsedBins < p2.nbUsedBins;
+}
+
 /**
 Bin construction heuristic
 */
 void constructBinsVerticalSupport()
 {
+	PROFILE_SCOPE("constructBinsVerticalSupport");
 	infLoadBearing = 0;
 	infAreaSupport = 0;
 	inf4CSupport = 0;
@@ -872,12 +1697,12 @@ void constructBinsVerticalSupport()
 
 		double coveredSpace = 0;
 
-		for (int j = 0; j < layerList[i].itemList.size(); j++)
+		for (int j = 0; j < layerList[i].nbItems(); j++)
 		{
 			if (academicToggle == 1)
-				coveredSpace += layerList[i].itemList[j].w * layerList[i].itemList[j].d;
+				coveredSpace += layerList[i].item(j).w * layerList[i].item(j).d;
 			else
-				coveredSpace += layerList[i].itemList[j].topSurfaceArea;
+				coveredSpace += layerList[i].item(j).topSurfaceArea;
 			//coveredSpace += itemList[i].w * itemList[i].d;
 
 		}
@@ -989,147 +1814,52 @@ void constructBinsVerticalSupport()
 
 	if (binPlacementHeuristic == 1)
 	{
-		//Try to place as many layers as possible to the open bins
-		while (layerList.size() > 0)
-		{
-			int bestLayerIndex = -1;
-			int bestBinIndex = -1;
-			double bestDensity = 0;
-			Layer bestLayer;
-
-			//Loop through layers
-			for (int i = 0; i < layerList.size(); i++)
-			{
-				Layer curLayer = layerList[i];
-
-				//Add layers to all open bins if they are empty
-				bool addedFlag = false;
-				bool jumpFlag = false;
-				for (int j = 0; j < openBinList.size(); j++)
-				{
-					if (openBinList[j].binLayers.size() == 0)
-					{
-						if (curLayer.layerOccupancy < 60.0)
-						{
-							jumpFlag = true;
-							break;
-						}
-						//Space the layer
-						if (BinWidth > 700)
-							spaceLayer(curLayer);
-						curLayer.unpack();
-						openBinList[j].binLayers.push_back(curLayer);
-						openBinList[j].unpackLayer(curLayer);
-						openBinList[j].height += curLayer.layerHeight;
-						openBinList[j].weight += curLayer.weight;
-						updateCoveredList(coveredList, curLayer);
-						addedFlag = true;
-						bestLayerIndex = -2;
-						break;
-					}
-				}
-
-				if (jumpFlag == true)
-					continue;
-
-				if (addedFlag == true)
-					break;
-
-
-				for (int j = 0; j < openBinList.size(); j++)
-				{
-					if (openBinList[j].weight + curLayer.weight > maxBinWeight)
-						break;
-
-					Layer tempLayer = curLayer;
-					//Space the layer to maximize support
-					if(BinWidth > 700)
-						maximizeSupport(openBinList[j].binLayers.back(), curLayer);
-					curLayer.unpack();
-					//If the layer is 100% supported from the bottom, add the layer
-					if (layerFeasibility(curLayer, openBinList[j]))
-					{
-						if (curLayer.layerOccupancy > bestDensity)
-						{
-							bestDensity = curLayer.layerOccupancy;
-							bestLayerIndex = i;
-							bestBinIndex = j;
-							bestLayer = curLayer;
-						}
-					}
-					else
-						curLayer = tempLayer;
-
-					if (bestBinIndex >= 0)
-						break;
-				}//for (int j = 0; j < openBinList.size(); j++)
-				if (bestLayerIndex >= 0)
-					break;
-			}//for (int i = 0; i < layerList.size(); i++)
-
-			if (bestLayerIndex >= 0)
-			{
-				openBinList[bestBinIndex].binLayers.push_back(bestLayer);
-				openBinList[bestBinIndex].unpackLayer(bestLayer);
-
-				openBinList[bestBinIndex].height += bestLayer.layerHeight;
-				openBinList[bestBinIndex].weight += bestLayer.weight;
-				updateCoveredList(coveredList, bestLayer);
-
-				//Add bin to the final bin list if it is full
-				if (openBinList[bestBinIndex].height > normalLayerHeight)
-				{
-					newBinList.push_back(openBinList[bestBinIndex]);
-					openBinList.erase(openBinList.begin() + bestBinIndex);
-				}
-			}
-
-			if (bestLayerIndex == -1)
-			{
-				//layerList.clear();
-				break;
-			}
-		
-			
-			if (openBinList.size() == 0)
-				break;
+		//Pool the items of the super items before the passes, so that the passes do not change the layer item pool
+		poolSuperItemParts(layerList);
 
-			for (int i = layerList.size() - 1; i >= 0; i--)
-			{
-				/*if (isItCovered(coveredList, layerList[i]))
-				{
-					Layer tempLayer = layerList[i];
-					layerList[i] = layerList.back();
-					layerList.back() = tempLayer;
-					layerList.pop_back();
-				}*/
-
-				removeCoveredItems(coveredList, layerList[i]);
-				layerList[i].calculateLayerOccupancy();
-			}
+		//Set up the passes, each with its own layer ordering and copies of the bin construction state
+		vector<BinConstructionPass> passes(max(binConstructionPasses, 1));
+		for (int p = 0; p < passes.size(); p++)
+		{
+			passes[p].ordering = p;
+			passes[p].layers = layerList;
+			passes[p].covered = coveredList;
+			passes[p].items = uniqueItemList;
+			passes[p].openBinList = openBinList;
 
-			//Remove layers with less than 60% density
-			for (int i = 0; i < layerList.size(); i++)
+			if (p >= 3)
 			{
-				if (layerList[i].layerOccupancy < 40.0)
-				{
-					Layer tempLayer = layerList.back();
-					layerList.back() = layerList[i];
-					layerList[i] = tempLayer;
-					layerList.pop_back();
-					i--;
-				}
+				mt19937 generator(p);
+				uniform_real_distribution<double> distribution(-layerOrderNoise, layerOrderNoise);
+				passes[p].noise.resize(layerList.size());
+				for (int i = 0; i < layerList.size(); i++)
+					passes[p].noise[i] = distribution(generator);
 			}
+		}
 
-			//Sort the layers based on decreasing density
-			sort(layerList.begin(), layerList.end());
+		if (passes.size() == 1)
+			runBinConstructionPass(passes[0]);
+		else
+			getThreadPool().parallelFor(passes.size(), [&](int p) { runBinConstructionPass(passes[p]); });
 
-			//Sort the layers based on decreasing average load cap
-			//sort(layerList.begin(), layerList.end(), &sortLayersLoadCap);
+		//Keep the state of the best pass
+		int bestPass = 0;
+		for (int p = 1; p < passes.size(); p++)
+		{
+			if (betterPass(passes[p], passes[bestPass]))
+				bestPass = p;
+		}
 
-		}//while (layerList.size() > 0)
+		layerList = std::move(passes[bestPass].layers);
+		coveredList = std::move(passes[bestPass].covered);
+		uniqueItemList = std::move(passes[bestPass].items);
+		openBinList = std::move(passes[bestPass].openBinList);
+		newBinList = std::move(passes[bestPass].newBinList);
 	}//if (binPlacementHeuristic == 1)
 
+	//Covered items were removed from the layers, so rebuild the signature index for the next batch
+	removeDuplicateLayers();
+
 	//If there are any open bins remaining, add them to the new bin list
 	if (openBinList.size() > 0)
 		for (int i = 0; i < openBinList.size(); i++)
@@ -1153,8 +1883,7 @@ void constructBinsVerticalSupport()
 		for (int i = 0; i < newBinList.size(); i++)
 		{
 			placeLeftovers(newBinList[i], leftoverItems);
-			newBinList[i].epList.clear();
-			binList.push_back(newBinList[i]);
+			closeBin(newBinList[i]);
 		}
 	}
 
@@ -1171,8 +1900,7 @@ void constructBinsVerticalSupport()
 			Bin newBin;
 			newBin.initiateEPList();
 			placeLeftovers(newBin, leftoverItems);
-			newBin.epList.clear();
-			binList.push_back(newBin);
+			closeBin(newBin);
 		}
 	}
 
@@ -1180,50 +1908,172 @@ void constructBinsVerticalSupport()
 }
 
 /**
-Write results
-NOTE: The values at the end of each line are there to ensure compatibility with 
-the previous pallet visualization code from WanOpt. They can safely be removed.
-@param file name
+Calculate the volume of the items in a bin
+@param a bin object
+@return the item volume
+*/
+double binItemVolume(const Bin &bin)
+{
+	double volume = 0;
+	for (int i = 0; i < bin.itemList.size(); i++)
+		volume += (double)bin.itemWidths[i] * bin.itemDepths[i] * bin.itemHeights[i];
+
+	return volume;
+}
+
+/**
+Local search on the constructed bins that tries to empty the least filled bin by moving its items to the extreme points on top of the other bins
+Items are placed with placeLeftovers, so the support, load bearing and bin weight checks are the same as for leftover items, and the candidate placements are evaluated in parallel in leftoverPlacementMode 1
+With planogram sequencing the items of a bin can only move to its neighbouring bins
+@return the number of bins that are emptied
 */
-void writeBins(string filename)
+int improveBins()
 {
-	//std::cout << "Writing results to files." << endl;
-	vector<Bin> newList;
-	//int binListSize = (int)(binList.size() / 2);
-	for (int i = 0; i < binList.size(); i++)
+	PROFILE_SCOPE("improveBins");
+	double start = wallClock();
+	int nbEmptied = 0;
+	vector<bool> tried(binList.size(), false);
+
+	while (binList.size() > 1 && wallClock() - start < localSearchTimeLimit)
 	{
-		if (i % 2 == 1)
+		//Find the least filled bin that has not been tried since the last improvement
+		int emptyIndex = -1;
+		double minVolume = 0;
+		for (int b = 0; b < binList.size(); b++)
+		{
+			double volume = binItemVolume(binList[b]);
+			if (!tried[b] && (emptyIndex == -1 || volume < minVolume))
+			{
+				emptyIndex = b;
+				minVolume = volume;
+			}
+		}
+		if (emptyIndex == -1)
+			break;
+		tried[emptyIndex] = true;
+
+		//Target bins, the ones with the most free volume first
+		vector<pair<double, int>> targets;
+		for (int b = 0; b < binList.size(); b++)
+		{
+			if (b == emptyIndex || (planogramSeqToggle == 1 && abs(b - emptyIndex) > 1))
+				continue;
+			targets.push_back(make_pair(binItemVolume(binList[b]), b));
+		}
+		sort(targets.begin(), targets.end());
+
+		//The moved items do not support or carry anything in their new bins yet
+		vector<Item> savedItemList = uniqueItemList;
+		vector<Item> movedItems;
+		for (int i = 0; i < binList[emptyIndex].itemList.size(); i++)
+		{
+			Item &curItem = uniqueItemList[binList[emptyIndex].itemList[i]];
+			curItem.totalSupportedWeight = 0;
+			curItem.supportedItems.clear();
+			curItem.supportPercentages.clear();
+			movedItems.push_back(curItem);
+		}
+
+		//Try to move all the items into a single target bin. The targets are tried in parallel on copies of the bin and the item list,
+		//a wave of as many targets as there are threads at a time, and the first target in order that takes all the items is kept
+		vector<Bin> trialBins;
+		ThreadPool &pool = getThreadPool();
+		int waveSize = pool.size();
+		bool emptied = false;
+		for (int first = 0; first < targets.size() && !emptied; first += waveSize)
+		{
+			int nbTrials = min(waveSize, (int)targets.size() - first);
+			vector<Bin> trialTargets(nbTrials);
+			vector<vector<Item>> trialItems(nbTrials);
+			vector<vector<Item>> trialLeftovers(nbTrials, movedItems);
+			vector<int> trialInfeasibility(nbTrials * 6, 0);
+
+			pool.parallelFor(nbTrials, [&](int t)
+			{
+				trialTargets[t] = binList[targets[first + t].second];
+				trialItems[t] = uniqueItemList;
+				placeLeftovers(trialTargets[t], trialLeftovers[t], trialItems[t], &trialInfeasibility[t * 6]);
+				trialTargets[t].epList.clear();
+			});
+
+			for (int t = 0; t < nbTrials && !emptied; t++)
+			{
+				if (trialLeftovers[t].size() > 0)
+					continue;
+
+				trialBins = binList;
+				trialBins[targets[first + t].second] = std::move(trialTargets[t]);
+				uniqueItemList = std::move(trialItems[t]);
+				for (int result = 1; result < 6; result++)
+					countInfeasibility(result, trialInfeasibility[t * 6 + result]);
+				emptied = true;
+			}
+		}
+
+		//Otherwise spread the items over the targets, the ones with the most free volume first
+		if (!emptied)
 		{
-			for (int j = 0; j < binList[i].itemList.size(); j++)
+			//Failed moves must not change the infeasibility counters of the solution
+			int savedInfeasibility[4] = { infAreaSupport, inf4CSupport, infLoadBearing, infBinWeight };
+
+			trialBins = binList;
+			for (int t = 0; t < targets.size() && movedItems.size() > 0; t++)
+			{
+				Bin &targetBin = trialBins[targets[t].second];
+				placeLeftovers(targetBin, movedItems);
+				targetBin.epList.clear();
+			}
+
+			//Keep the moves only if the bin is emptied
+			if (movedItems.size() > 0)
 			{
-				binList[i - 1].itemXCoords.push_back(binList[i].itemXCoords[j] + BinWidth);
-				binList[i - 1].itemYCoords.push_back(binList[i].itemYCoords[j]);
-				binList[i - 1].itemZCoords.push_back(binList[i].itemZCoords[j]);
-				binList[i - 1].itemWidths.push_back(binList[i].itemWidths[j]);
-				binList[i - 1].itemDepths.push_back(binList[i].itemDepths[j]);
-				binList[i - 1].itemHeights.push_back(binList[i].itemHeights[j]);
+				uniqueItemList = savedItemList;
+				infAreaSupport = savedInfeasibility[0];
+				inf4CSupport = savedInfeasibility[1];
+				infLoadBearing = savedInfeasibility[2];
+				infBinWeight = savedInfeasibility[3];
+				continue;
 			}
-			newList.push_back(binList[i - 1]);
 		}
+
+		trialBins.erase(trialBins.begin() + emptyIndex);
+		binList = std::move(trialBins);
+		tried.assign(binList.size(), false);
+		nbEmptied++;
 	}
 
-	if (binList.size() % 2 == 1)
-		newList.push_back(binList.back());
+	return nbEmptied;
+}
+
+/**
+Number of carriers the bins are written on, binsPerCarrier consecutive bins share a carrier
+@param the number of bins
+@return the number of carriers
+*/
+int nbCarriers(int nbBins)
+{
+	return (nbBins + binsPerCarrier - 1) / binsPerCarrier;
+}
 
-	binList = newList;
+/**
+Write the bins of a carrier as a text file, Results/<instance>/currentbin<carrier>.txt
+The bins of a carrier are written side by side, the items of its n-th bin are shifted by n times the bin width
+NOTE: The values at the end of each line are there to ensure compatibility with 
+the previous pallet visualization code from WanOpt. They can safely be removed.
+@param file name, and the carrier index
+*/
+void writeCarrierFile(const string &filename, int carrier)
+{
+	ofstream resultingBins;
+	string fileName = "Results/" + filename + "/currentbin" + to_string(carrier) + ".txt";
+	resultingBins.open(fileName);
 
-	for (int b = 0; b < binList.size(); b++)
+	for (int b = carrier * binsPerCarrier; b < binList.size() && b < (carrier + 1) * binsPerCarrier; b++)
 	{
-		ofstream resultingBins;
-		char fileName[100];
-		sprintf(fileName, "Results/");
-		sprintf(fileName + strlen(fileName), filename.c_str());
-		sprintf(fileName + strlen(fileName), "/currentbin%d.txt", b);
-		resultingBins.open(fileName);
-
+		int xOffset = (b - carrier * binsPerCarrier) * BinWidth;
 		for (int i = 0; i < binList[b].itemWidths.size(); i++)
 		{
-			resultingBins << binList[b].itemXCoords[i] << " "
+			resultingBins << binList[b].itemXCoords[i] + xOffset << " "
 				<< binList[b].itemYCoords[i] << " "
 				<< binList[b].itemZCoords[i] << " "
 				<< binList[b].itemWidths[i] << " "
@@ -1232,9 +2082,8 @@ void writeBins(string filename)
 				<< "5" << " "
 				<< "11585 2 128650" << endl;
 		}
-		resultingBins.close();
-		//calcBins.push_back(newBin);
-	}//for (int i = 0; i < binLayers.size(); i++)
+	}
+	resultingBins.close();
 }
 
 #endif
\ No newline at end of file
@@ -6,6 +6,218 @@
 #include "Layer.h"
 #include "Bin.h"
 
+vector<double> rawDuals;			//Duals of the covering constraints from the last master solve
+vector<double> stabilityCenter;		//Duals that the next duals are smoothed towards
 
+/**
+@return the CPLEX environment of the master problems, created once so that the batches and the instances solved by a process share it
+*/
+IloEnv masterEnvironment()
+{
+	static IloEnv env;
+	return env;
+}
+
+/**
+Read the duals of the item covering constraints of the master problem
+@param the solved CPLEX object, the covering constraints, and the list the duals are written to
+*/
+void readDuals(IloCplex &cplex, IloRangeArray &range, vector<double> &duals)
+{
+	IloNumArray values(cplex.getEnv());
+	cplex.getDuals(values, range);
+
+	duals.resize(values.getSize());
+	for (int i = 0; i < duals.size(); i++)
+		duals[i] = values[i];
+
+	values.end();
+}
+
+/**
+Smooth the duals towards the stability center (Wentges smoothing), and move the center to the smoothed duals
+The first duals of a batch become the center as they are
+@param the duals of the last master solve and the list the smoothed duals are written to
+@return the L1 distance between the duals and the stability center
+*/
+double smoothDuals(const vector<double> &duals, vector<double> &smoothedDuals)
+{
+	double dualStep = 0;
+
+	if (stabilityCenter.size() != duals.size())
+	{
+		smoothedDuals = duals;
+		stabilityCenter = duals;
+		return dualStep;
+	}
+
+	smoothedDuals.resize(duals.size());
+	for (int i = 0; i < duals.size(); i++)
+	{
+		dualStep += abs(duals[i] - stabilityCenter[i]);
+		smoothedDuals[i] = dualSmoothingFactor * stabilityCenter[i] + (1 - dualSmoothingFactor) * duals[i];
+	}
+	stabilityCenter = smoothedDuals;
+
+	return dualStep;
+}
+
+/**
+Copy duals into the reduced costs of the items used by pricing
+@param a dual value for every unique item
+*/
+void applyDuals(const vector<double> &duals)
+{
+	for (int i = 0; i < uniqueItemList.size(); i++)
+		uniqueItemList[i].reducedCost = duals[i];
+
+	for (int j = 0; j < itemList.size(); j++)
+		itemList[j].reducedCost = duals[itemList[j].ID];
+
+	//Update the dual values of the super items
+	for (int i = 0; i < superItems.size(); i++)
+	{
+		superItems[i].reducedCost = 0;
+		for (int j = 0; j < superItems[i].SIList.size(); j++)
+		{
+			superItems[i].reducedCost += duals[superItems[i].SIList[j].ID];
+		}
+	}
+}
+
+/**
+Calculate a lower bound on the master LP from the exact duals of the master LP and the results of pricing with them in generateLayers
+The duals must not be smoothed: the smoothed duals are not feasible for the dual of the master LP, and their sum can exceed its objective
+Lagrangian bound: every layer is at least shortestHeight high, so at most objective / shortestHeight layers are selected, which gives sum(duals) + objective / shortestHeight * min reduced cost
+Farley bound: the duals divided by (1 - min reduced cost to height ratio) are feasible, which gives sum(duals) / (1 - min ratio)
+Both bounds assume that pricing finds the most negative reduced cost. MaxRects pricing is a heuristic, so with it the bound is an estimate.
+@param the duals of the master LP, which were used in the last pricing, and the master objective value
+@return the larger of the two bounds
+*/
+double lagrangianBound(const vector<double> &duals, double objective)
+{
+	double dualSum = 0;
+	for (int i = 0; i < duals.size(); i++)
+		dualSum += duals[i];
+
+	double minReducedCost = 0;
+	double minRatio = 0;
+	for (int g = 0; g < groupReducedCosts.size(); g++)
+	{
+		minReducedCost = min(minReducedCost, groupReducedCosts[g]);
+		minRatio = min(minRatio, groupReducedCostRatios[g]);
+	}
+
+	double lagrangian = dualSum + objective / shortestHeight * minReducedCost;
+	double farley = dualSum / (1 - minRatio);
+
+	return max(lagrangian, farley);
+}
+
+/**
+Write the convergence report of a column generation iteration
+@param iteration number, master objective value, best lower bound, L1 distance of the duals from the stability center, number of mispricings so far, and elapsed seconds
+*/
+void logIteration(int iteration, double objective, double bound, double dualStep, int mispricings, double seconds)
+{
+	cout << "Iteration " << iteration << "\tObjective: " << objective << "\tBound: " << bound << "\tGap: " << (objective - bound) / objective <<
+		"\tColumns: " << layerList.size() << "\tDual step: " << dualStep << "\tMispricings: " << mispricings << "\tTime: " << seconds << endl;
+}
+
+/**
+Dive on the master LP to turn its fractional solution into a set of layers that cover every item at most once
+In every step the columns with the largest LP values are fixed to 1 and the columns that share items with them are fixed to 0, until no free column has a positive value, the LP turns infeasible, or divingSolveLimit is reached
+The selected layers get alpha = 1 in layerList, the other layers keep their last LP value
+@param the master model and the column variables
+@return the number of selected layers
+*/
+int diveLayerSelection(IloModel &mod, IloNumVarArray &alpha)
+{
+	int nbColumns = alpha.getSize();
+	for (int k = 0; k < layerList.size(); k++)
+		layerList[k].alpha = 0;
+
+	//Index the columns by the items they contain
+	vector<vector<int>> itemColumns(uniqueItemList.size());
+	vector<vector<int>> columnItems(nbColumns);
+	for (int k = 0; k < nbColumns; k++)
+	{
+		getLayerItemIDs(layerList[k], columnItems[k]);
+		for (int i = 0; i < columnItems[k].size(); i++)
+			itemColumns[columnItems[k][i]].push_back(k);
+	}
+
+	//Aged columns may be needed to keep the LP feasible while diving
+	for (int k = 0; k < nbColumns; k++)
+		alpha[k].setUB(1);
+
+	//-1: free		0, 1: fixed value
+	vector<int> fixedValue(nbColumns, -1);
+	vector<bool> covered(uniqueItemList.size(), false);
+	int nbSelected = 0;
+
+	IloCplex cplex(mod);
+	cplex.setOut(mod.getEnv().getNullStream());
+	IloNumArray values(mod.getEnv());
+
+	for (int solve = 0; solve < divingSolveLimit; solve++)
+	{
+		if (!cplex.solve())
+			break;
+		cplex.getValues(values, alpha);
+
+		//Free columns with positive value, largest value first
+		vector<pair<double, int>> candidates;
+		for (int k = 0; k < nbColumns; k++)
+		{
+			if (fixedValue[k] != -1)
+				continue;
+			layerList[k].alpha = values[k];
+			if (values[k] > 1e-6)
+				candidates.push_back(make_pair(-values[k], k));
+		}
+		if (candidates.size() == 0)
+			break;
+		sort(candidates.begin(), candidates.end());
+
+		//Fix the best column, and the other disjoint columns above the threshold, to 1
+		for (int c = 0; c < candidates.size(); c++)
+		{
+			int k = candidates[c].second;
+			if (c > 0 && -candidates[c].first < divingFixThreshold)
+				break;
+			if (fixedValue[k] != -1)
+				continue;
+
+			fixedValue[k] = 1;
+			alpha[k].setLB(1);
+			layerList[k].alpha = 1;
+			nbSelected++;
+
+			//Columns that cover the same items cannot be selected anymore
+			for (int i = 0; i < columnItems[k].size(); i++)
+			{
+				int itemID = columnItems[k][i];
+				if (covered[itemID])
+					continue;
+				covered[itemID] = true;
+				for (int j = 0; j < itemColumns[itemID].size(); j++)
+				{
+					int other = itemColumns[itemID][j];
+					if (fixedValue[other] != -1)
+						continue;
+					fixedValue[other] = 0;
+					alpha[other].setUB(0);
+					layerList[other].alpha = 0;
+				}
+			}
+		}
+	}
+
+	values.end();
+	cplex.end();
+
+	return nbSelected;
+}
 
 #endif
\ No newline at end of file
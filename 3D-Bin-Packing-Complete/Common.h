@@ -3,13 +3,29 @@
 
 #include <vector>
 #include <queue>
+#include <deque>
+#include <map>
+#include <unordered_map>
 #include <fstream>
 #include <string>
 #include <algorithm>
 #include <ctime>
+#include <random>
+#include <iostream>
+#include <cmath>
+#include <climits>
+#include <functional>
+#include <stdexcept>
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
 #include "Rect.h"
 #include "MaxRectsBinPack.h"
-#include "ilcplex\ilocplex.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#ifndef NO_CPLEX
+#include <ilcplex/ilocplex.h>
+#endif
 
 //*********************************
 //PARAMETERS
@@ -55,6 +71,51 @@ int normalLayerHeight = 0.8 * BinHeight;			//Height that the layers will be plac
 #define binPlacementHeuristic 1			// 1: Bottom to Top
 #define minEdgeRatio 0.8				// Minimum edge length ratio for super items
 #define epIncrement 50					// Increment of coordinates that is used during extreme point generation
+
+//Leftover placement parameters
+#define leftoverPlacementMode 0			// 0: First feasible placement in scan order		1: Best placement among all candidates, evaluated in parallel
+#define nbThreads 4						// Number of threads used for parallel evaluations (including the main thread)
+#define leftoverLogToggle 0				// Toggles a report of the remaining leftover items after every leftover placement (single threaded runs only, the reports of parallel trial moves interleave)
+
+//Bin construction parameters
+#define binConstructionPasses 1			// Nb bin construction passes run in parallel, each with its own layer ordering (density, load cap, LP value, then randomized), the best one is kept
+#define layerOrderNoise 0.05			// Max relative density perturbation of the layers in randomized bin construction passes
+#define localSearchTimeLimit 0			// Time limit (s) of the local search that empties the least filled bins after all bins are constructed (0: no local search)
+
+//Layer spacing parameters
+#define spacingCacheToggle 1			// Toggles the cache of layer spacing results
+#define spacingCacheLimit 200000		// Nb cached spacing results after which the cache is emptied
+#define spacingEngine 1					// 0: CPLEX models		1: Combinatorial compaction		2: Combinatorial compaction refined by the CPLEX models
+#ifdef NO_CPLEX
+#undef spacingEngine
+#define spacingEngine 1					// Builds without CPLEX only have the combinatorial compaction
+#endif
+
+//Column generation parameters
+#define dualSmoothingFactor 0.5			// Wentges smoothing factor for the duals used in pricing, in [0, 1)		0: No smoothing
+#define pricingEngine 1					// 0: MaxRects heuristic		1: MaxRects pre-pass, followed by the guillotine DP generator for groups it finds no layer for
+#define pricingGridStep 10				// Grid step (mm) of the width knapsack in the guillotine DP generator
+#define cgGapTolerance 0				// Column generation stops when the relative gap between the master objective and its lower bound is below this value, the bound only holds if pricing finds the most negative reduced cost, which neither pricing engine guarantees		0: Never
+#define cgLogToggle 0					// Toggles per iteration column generation convergence reports
+
+//Column pool parameters
+#define columnAgingLimit 10				// Nb consecutive master solves with positive reduced cost after which a column leaves the LP (0: never)
+#define columnPoolMemoryLimit 256		// Memory limit of the columns in and out of the LP in MB, beyond it the columns that left the LP longest ago are purged and kept for bin construction, and the longest purged ones are dropped
+#define columnPoolLogToggle 0			// Toggles per iteration column pool reports
+
+//Layer selection parameters
+#define divingToggle 1					// Toggles diving on the final master LP to select layers that cover every item at most once, bin construction places them first
+#define divingSolveLimit 50				// Max nb LP solves during diving
+#define divingFixThreshold 0.9			// Columns with at least this LP value are fixed to 1 together in a dive step
+
+//Profiling parameters
+#define profileToggle 1					// Toggles the per phase wall clock breakdown written to Results/<instance>/Profile.txt
+
+//Output parameters
+#define solutionFormat 1				// 0: Text file per bin, SolutionStats.txt and Profile.txt		1: JSON lines in Solution.jsonl		2: Binary records in Solution.bin
+#define solutionBufferSize (1 << 20)	// Size (bytes) the solution writer buffers before writing to the file
+#define solutionFormatVersion 3			// Version written to the header of the binary format
+#define binsPerCarrier 2				// Bins written side by side as one carrier, each shifted by the bin width		1: Single bins		2: Paired bins (double pallet)		N: N bins per carrier
 int nItems;
 int nbLines;
 int shortestHeight = BinHeight;
@@ -74,6 +135,7 @@ int infBinWeight;
 
 using namespace std;
 
+#ifndef NO_CPLEX
 //Type definitions for CPLEX parameters and variables
 typedef IloArray<IloNumArray> Float2Matrix;
 typedef IloArray<Float2Matrix> Float3Matrix;
@@ -86,6 +148,7 @@ typedef IloArray<Var3Matrix> Var4Matrix;
 typedef IloArray<IloRangeArray> Range2Matrix;
 typedef IloArray<Range2Matrix> Range3Matrix;
 typedef IloArray<Range3Matrix> Range4Matrix;
+#endif
 
 //Extreme point structure for ease of use
 //An extreme point is a candidate location for single item placement
@@ -94,12 +157,53 @@ struct extremePoint
 	//Coordinates of the extreme point
 	int x, y, z;
 
+	//Free space around the extreme point for each corner of an item that can be placed at it (see Bin::setEPSpace)
+	//Corners->  0: front left		1: back left		2: front right		3: back right
+	int freeW[4], freeD[4], freeH[4];
+	int maxFreeShort, maxFreeLong, maxFreeH;	//Largest free space over all corners, for the short and long sides and the height of an item
+	bool spaceSet;				//True if the free space values are calculated
+
 	//Default constructor
-	struct extremePoint()
+	extremePoint()
 	{
 		this->x = 0;
 		this->y = 0;
 		this->z = 0;
+		this->spaceSet = false;
+	}
+
+	/**
+	Check if an item can fit into the free space of the extreme point, without any overlap or load calculations
+	@param width, depth, height dimensions of the item, and the corner of the item placed at the extreme point
+	@return false if the item certainly overlaps with an item in the bin or exceeds the bin
+	*/
+	bool fits(int w, int d, int h, int corner) const
+	{
+		return w <= freeW[corner] && d <= freeD[corner] && h <= freeH[corner];
+	}
+
+	/**
+	Check if an item can fit into the free space of the extreme point in any orientation and at any corner
+	@param the short and long sides of the width-depth dimensions, and the height of the item
+	@return false if the item cannot be placed at the extreme point
+	*/
+	bool fitsAny(int shortSide, int longSide, int h) const
+	{
+		return shortSide <= maxFreeShort && longSide <= maxFreeLong && h <= maxFreeH;
+	}
+
+	/**
+	Update the largest free space values after the free space of a corner changes
+	*/
+	void updateMaxFreeSpace()
+	{
+		maxFreeShort = 0; maxFreeLong = 0; maxFreeH = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			maxFreeShort = max(maxFreeShort, min(freeW[c], freeD[c]));
+			maxFreeLong = max(maxFreeLong, max(freeW[c], freeD[c]));
+			maxFreeH = max(maxFreeH, freeH[c]);
+		}
 	}
 
 	//Destructor
@@ -130,6 +234,16 @@ bool sortEP(const extremePoint &e1, extremePoint &e2)
 		return false;
 }
 
+/**
+Get the shared pool of worker threads, created on first use
+@return the thread pool
+*/
+ThreadPool &getThreadPool()
+{
+	static ThreadPool pool(nbThreads - 1);
+	return pool;
+}
+
 //Container for file parsing
 template <typename Container>
 Container& split(Container& result,
@@ -302,4 +416,250 @@ double calculateOverlap(int x1, int y1, int w1, int d1, int x2, int y2, int w2,
 	return overlap;
 }
 
+//Support surface of an item for one orientation of its footprint, relative to the front left corner of the footprint
+//FULL uses the edge reduced footprint, ALL_EDGES, SHORT_EDGES and LONG_EDGES subtract one inside rectangle from it, and CORNERS adds four corner squares
+struct SupportShape
+{
+	int supportType;						//Support type of the item
+	int w, d;								//Footprint the shape is built for, -1 if the shape is not set
+	int gateX, gateY, gateXEnd, gateYEnd;	//Edge reduced footprint, items that do not touch it get no support
+	int rectX[4], rectY[4], rectXEnd[4], rectYEnd[4];	//Inside rectangle (slot 0) or the four corner squares
+
+	//Default constructor
+	SupportShape()
+	{
+		this->w = -1;
+		this->d = -1;
+	}
+};
+
+/**
+Build the support shape of an item, with the geometry of calculateOverlap
+@param the footprint width-depth of the item, its support type, and its edge reduce width-depth
+@return the support shape
+*/
+SupportShape makeSupportShape(int w1, int d1, int supportType1, int edgeReduceW1, int edgeReduceD1)
+{
+	SupportShape shape;
+	shape.supportType = supportType1;
+	shape.w = w1;
+	shape.d = d1;
+
+	int x1 = edgeReduceW1;
+	int y1 = edgeReduceD1;
+	w1 -= edgeReduceW1 * 2;
+	d1 -= edgeReduceD1 * 2;
+	shape.gateX = x1;
+	shape.gateY = y1;
+	shape.gateXEnd = x1 + w1;
+	shape.gateYEnd = y1 + d1;
+
+	//Inside rectangle that gives no support, it is narrowed in x if the edges along y support, and in y if the edges along x support
+	bool narrowX = supportType1 == 1 || (supportType1 == 2 && w1 >= d1) || (supportType1 == 3 && w1 <= d1);
+	bool narrowY = supportType1 == 1 || (supportType1 == 2 && w1 < d1) || (supportType1 == 3 && w1 > d1);
+	shape.rectX[0] = narrowX ? x1 + edgeSupportThickness : x1;
+	shape.rectXEnd[0] = narrowX ? x1 + w1 - edgeSupportThickness : x1 + w1;
+	shape.rectY[0] = narrowY ? y1 + edgeSupportThickness : y1;
+	shape.rectYEnd[0] = narrowY ? y1 + d1 - edgeSupportThickness : y1 + d1;
+
+	if (supportType1 == 4)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			shape.rectX[c] = c < 2 ? x1 : x1 + (w1 - edgeSupportThickness);
+			shape.rectY[c] = c % 2 == 0 ? y1 : y1 + (d1 - edgeSupportThickness);
+			shape.rectXEnd[c] = shape.rectX[c] + edgeSupportThickness;
+			shape.rectYEnd[c] = shape.rectY[c] + edgeSupportThickness;
+		}
+	}
+
+	return shape;
+}
+
+/**
+Signed overlap area of two rectangles, not clamped at 0 as in calculateOverlap
+@param start and end coordinates of both rectangles
+@return the overlap area, negative if the rectangles are apart in one dimension only
+*/
+inline int rectOverlap(int xStart1, int yStart1, int xEnd1, int yEnd1, int xStart2, int yStart2, int xEnd2, int yEnd2)
+{
+	return (min(xEnd1, xEnd2) - max(xStart1, xStart2)) * (min(yEnd1, yEnd2) - max(yStart1, yStart2));
+}
+
+/**
+Overlap kernel of a support type, the same value as calculateOverlap with the precomputed shape
+Item 1 (the shape) is at the bottom and Item 2 is on top
+@param the support shape and the x-y coordinates of item 1, and the x-y coordinates and width-depth of item 2
+@return total overlap area value between items
+*/
+template <int supportType>
+inline int supportOverlap(const SupportShape &shape, int x1, int y1, int x2, int y2, int w2, int d2)
+{
+	//Edge support types: the edge reduced footprint without the inside rectangle
+	if (x1 + shape.gateXEnd < x2 || y1 + shape.gateYEnd < y2 || x2 + w2 < x1 + shape.gateX || y2 + d2 < y1 + shape.gateY)
+		return 0;
+
+	return rectOverlap(x1 + shape.gateX, y1 + shape.gateY, x1 + shape.gateXEnd, y1 + shape.gateYEnd, x2, y2, x2 + w2, y2 + d2)
+		- rectOverlap(x1 + shape.rectX[0], y1 + shape.rectY[0], x1 + shape.rectXEnd[0], y1 + shape.rectYEnd[0], x2, y2, x2 + w2, y2 + d2);
+}
+
+template <>
+inline int supportOverlap<0>(const SupportShape &shape, int x1, int y1, int x2, int y2, int w2, int d2)
+{
+	//Full support: the edge reduced footprint
+	if (x1 + shape.gateXEnd < x2 || y1 + shape.gateYEnd < y2 || x2 + w2 < x1 + shape.gateX || y2 + d2 < y1 + shape.gateY)
+		return 0;
+
+	return rectOverlap(x1 + shape.gateX, y1 + shape.gateY, x1 + shape.gateXEnd, y1 + shape.gateYEnd, x2, y2, x2 + w2, y2 + d2);
+}
+
+template <>
+inline int supportOverlap<4>(const SupportShape &shape, int x1, int y1, int x2, int y2, int w2, int d2)
+{
+	//Corner support: the four corner squares
+	if (x1 + shape.gateXEnd < x2 || y1 + shape.gateYEnd < y2 || x2 + w2 < x1 + shape.gateX || y2 + d2 < y1 + shape.gateY)
+		return 0;
+
+	int overlap = 0;
+	for (int c = 0; c < 4; c++)
+		overlap += rectOverlap(x1 + shape.rectX[c], y1 + shape.rectY[c], x1 + shape.rectXEnd[c], y1 + shape.rectYEnd[c], x2, y2, x2 + w2, y2 + d2);
+	return overlap;
+}
+
+/**
+Calculates width-depth overlap between two items with the precomputed support shape of item 1. Item 1 is at the bottom and Item 2 is on top
+@param the support shape and the x-y coordinates of item 1, and the x-y coordinates and width-depth of item 2
+@return total overlap area value between items, based on item shapes
+*/
+inline double calculateOverlap(const SupportShape &shape, int x1, int y1, int x2, int y2, int w2, int d2)
+{
+	switch (shape.supportType)
+	{
+	case 0:
+		return supportOverlap<0>(shape, x1, y1, x2, y2, w2, d2);
+	case 4:
+		return supportOverlap<4>(shape, x1, y1, x2, y2, w2, d2);
+	default:
+		return supportOverlap<1>(shape, x1, y1, x2, y2, w2, d2);
+	}
+}
+
+//Support shapes of a set of placed items, laid out for the batched overlap kernel
+//Items are stored in blocks of 4, a block holds the 4 rectangle slots of its items slot by slot (index: block * 16 + slot * 4 + item in block)
+//Every slot has a sign: the edge reduced footprint is added, the inside rectangle is subtracted, and unused slots have sign 0
+struct SupportBatch
+{
+	int nbItems;										//Number of items in the batch
+	vector<int> gateX, gateY, gateXEnd, gateYEnd;		//Absolute edge reduced footprints, padded to a multiple of 4 items
+	vector<int> rectX, rectY, rectXEnd, rectYEnd, rectSign;	//Absolute rectangle slots and their signs
+	vector<int> overlaps;								//Overlaps computed by the last supportOverlaps call, padded to a multiple of 4 items
+
+	//Constructor
+	SupportBatch()
+	{
+		this->nbItems = 0;
+	}
+
+	//Remove all items, keeping the memory
+	void clear()
+	{
+		this->nbItems = 0;
+		this->gateX.clear(); this->gateY.clear(); this->gateXEnd.clear(); this->gateYEnd.clear();
+		this->rectX.clear(); this->rectY.clear(); this->rectXEnd.clear(); this->rectYEnd.clear(); this->rectSign.clear();
+	}
+
+	/**
+	Add a placed item
+	@param the support shape of the item and its x-y coordinates
+	*/
+	void add(const SupportShape &shape, int x1, int y1)
+	{
+		//Open a new block, padding items are never touched by the gate
+		if (this->nbItems % 4 == 0)
+		{
+			this->gateX.resize(this->gateX.size() + 4, INT_MAX / 2);
+			this->gateY.resize(this->gateY.size() + 4, INT_MAX / 2);
+			this->gateXEnd.resize(this->gateXEnd.size() + 4, INT_MAX / 2);
+			this->gateYEnd.resize(this->gateYEnd.size() + 4, INT_MAX / 2);
+			this->rectX.resize(this->rectX.size() + 16, 0);
+			this->rectY.resize(this->rectY.size() + 16, 0);
+			this->rectXEnd.resize(this->rectXEnd.size() + 16, 0);
+			this->rectYEnd.resize(this->rectYEnd.size() + 16, 0);
+			this->rectSign.resize(this->rectSign.size() + 16, 0);
+			this->overlaps.resize(this->gateX.size(), 0);
+		}
+
+		int item = this->nbItems++;
+		this->gateX[item] = x1 + shape.gateX;
+		this->gateY[item] = y1 + shape.gateY;
+		this->gateXEnd[item] = x1 + shape.gateXEnd;
+		this->gateYEnd[item] = y1 + shape.gateYEnd;
+
+		//Slots of the shape: the footprint and the inside rectangle, or the four corners
+		int nbSlots = shape.supportType == 0 ? 1 : (shape.supportType == 4 ? 4 : 2);
+		for (int slot = 0; slot < nbSlots; slot++)
+		{
+			int index = (item / 4) * 16 + slot * 4 + item % 4;
+			int rect = shape.supportType == 4 ? slot : 0;
+			bool footprint = shape.supportType != 4 && slot == 0;
+			this->rectX[index] = x1 + (footprint ? shape.gateX : shape.rectX[rect]);
+			this->rectY[index] = y1 + (footprint ? shape.gateY : shape.rectY[rect]);
+			this->rectXEnd[index] = x1 + (footprint ? shape.gateXEnd : shape.rectXEnd[rect]);
+			this->rectYEnd[index] = y1 + (footprint ? shape.gateYEnd : shape.rectYEnd[rect]);
+			this->rectSign[index] = (shape.supportType == 4 || footprint) ? 1 : -1;
+		}
+	}
+};
+
+/**
+Calculates the width-depth overlaps of an item on top with every item of a batch, the same values as calculateOverlap
+The overlaps are written to batch.overlaps, 4 items at a time with SSE4.1 when available
+@param the batch of bottom items, and the x-y coordinates and width-depth of the top item
+*/
+void supportOverlaps(SupportBatch &batch, int x2, int y2, int w2, int d2)
+{
+	int nbBlocks = (batch.nbItems + 3) / 4;
+#if defined(__SSE4_1__) || defined(__AVX__)
+	__m128i topX = _mm_set1_epi32(x2), topY = _mm_set1_epi32(y2), topXEnd = _mm_set1_epi32(x2 + w2), topYEnd = _mm_set1_epi32(y2 + d2);
+	for (int block = 0; block < nbBlocks; block++)
+	{
+		__m128i overlap = _mm_setzero_si128();
+		for (int slot = 0; slot < 4; slot++)
+		{
+			int index = block * 16 + slot * 4;
+			__m128i xStart = _mm_max_epi32(_mm_loadu_si128((const __m128i*)&batch.rectX[index]), topX);
+			__m128i xEnd = _mm_min_epi32(_mm_loadu_si128((const __m128i*)&batch.rectXEnd[index]), topXEnd);
+			__m128i yStart = _mm_max_epi32(_mm_loadu_si128((const __m128i*)&batch.rectY[index]), topY);
+			__m128i yEnd = _mm_min_epi32(_mm_loadu_si128((const __m128i*)&batch.rectYEnd[index]), topYEnd);
+			__m128i area = _mm_mullo_epi32(_mm_sub_epi32(xEnd, xStart), _mm_sub_epi32(yEnd, yStart));
+			overlap = _mm_add_epi32(overlap, _mm_mullo_epi32(area, _mm_loadu_si128((const __m128i*)&batch.rectSign[index])));
+		}
+
+		//Items whose edge reduced footprint does not touch the top item give no support
+		int index = block * 4;
+		__m128i apart = _mm_or_si128(
+			_mm_or_si128(_mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)&batch.gateXEnd[index]), topX), _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)&batch.gateYEnd[index]), topY)),
+			_mm_or_si128(_mm_cmplt_epi32(topXEnd, _mm_loadu_si128((const __m128i*)&batch.gateX[index])), _mm_cmplt_epi32(topYEnd, _mm_loadu_si128((const __m128i*)&batch.gateY[index]))));
+		_mm_storeu_si128((__m128i*)&batch.overlaps[index], _mm_andnot_si128(apart, overlap));
+	}
+#else
+	for (int item = 0; item < nbBlocks * 4; item++)
+	{
+		if (batch.gateXEnd[item] < x2 || batch.gateYEnd[item] < y2 || x2 + w2 < batch.gateX[item] || y2 + d2 < batch.gateY[item])
+		{
+			batch.overlaps[item] = 0;
+			continue;
+		}
+
+		int overlap = 0;
+		for (int slot = 0; slot < 4; slot++)
+		{
+			int index = (item / 4) * 16 + slot * 4 + item % 4;
+			overlap += batch.rectSign[index] * rectOverlap(batch.rectX[index], batch.rectY[index], batch.rectXEnd[index], batch.rectYEnd[index], x2, y2, x2 + w2, y2 + d2);
+		}
+		batch.overlaps[item] = overlap;
+	}
+#endif
+}
+
 #endif
\ No newline at end of file
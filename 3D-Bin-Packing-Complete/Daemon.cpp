@@ -0,0 +1,296 @@
+#include "Solver.h"
+#include <sstream>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+//Solver daemon: one long running process that solves the instances sent to it over a Unix domain socket, so that
+//process start-up, the thread pool, the CPLEX environment of the master problems and the capacity of the solver lists are paid once
+//Usage: SolverDaemon [--socket path]		(default /tmp/binpacking3d.sock, only the owner of the daemon can connect)
+//Protocol, one request per connection, the instances are solved one at a time in the order of the connections:
+//	SOLVE <instance name>\n, the item lines in the format of the instance files (see parseItems), END\n
+//		The answer is the solution as the records of the solution file (see SolutionWriter.h), as JSON lines unless solutionFormat is 2.
+//		The carriers are sent as soon as their bins are final, and the connection is closed after the last record
+//	PING\n is answered with PONG\n, SHUTDOWN\n stops the daemon
+//	An invalid request is answered with a single ERROR <reason>\n line
+//Example: printf 'SOLVE order1\n300\t200\t150\t1000\t100\t0\t0\tFULL\t12\t1\nEND\n' | nc -U /tmp/binpacking3d.sock
+
+const size_t maxRequestBytes = 64 << 20;		//Requests longer than this are rejected
+const long long maxRequestItems = 1000000;		//Instances with more items than this are rejected
+const int connectionTimeout = 30;				//Seconds a read from or a write to a client may block before the connection is dropped
+
+/**
+Read a request from a connection, up to the END line of a SOLVE request or the end of a one line command
+@param the connection, and the string the request is written to
+@return false if the connection was closed before the request was complete or the request is too long
+*/
+bool readRequest(int connection, string &request)
+{
+	char chunk[65536];
+	request.clear();
+	while (request.size() <= maxRequestBytes)
+	{
+		ssize_t nbRead = read(connection, chunk, sizeof(chunk));
+		if (nbRead <= 0)
+			return false;
+		request.append(chunk, nbRead);
+
+		size_t lineEnd = request.find('\n');
+		if (lineEnd == string::npos)
+			continue;
+		if (request.compare(0, 5, "SOLVE") != 0)
+			return true;
+		if (request.find("\nEND\n", lineEnd - 1) != string::npos || request.find("\nEND\r\n", lineEnd - 1) != string::npos)
+			return true;
+	}
+	return false;
+}
+
+/**
+Send a line to a connection
+@param the connection, and the line without its end
+*/
+void sendLine(int connection, const string &line)
+{
+	string data = line + "\n";
+	size_t sent = 0;
+	while (sent < data.size())
+	{
+		ssize_t nbWritten = write(connection, data.data() + sent, data.size() - sent);
+		if (nbWritten <= 0)
+			return;
+		sent += nbWritten;
+	}
+}
+
+/**
+Check the item lines of a SOLVE request, so that a malformed request is rejected before the solver state is touched
+Items that fit an empty bin in neither orientation or are heavier than the bin weight limit are rejected too, the solver could not place them
+Empty lines and carriage returns are dropped
+@param the lines after the SOLVE line up to the END line, the string the checked lines are written to, and the string the reason of a rejection is written to
+@return false if a line does not describe an item type
+*/
+bool checkItemLines(const string &payload, string &items, string &error)
+{
+	istringstream input(payload);
+	string line;
+	vector<string> fields;
+	int nbFields = academicToggle == 1 ? 4 : 10;
+	int quantityField = academicToggle == 1 ? 3 : 8;
+	int lineNumber = 0;
+	long long nbItems = 0;
+	items.clear();
+
+	while (getline(input, line))
+	{
+		lineNumber++;
+		if (line.size() > 0 && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue;
+
+		split(fields, line, "\t");
+		if (fields.size() < nbFields)
+		{
+			error = "line " + to_string(lineNumber) + " has " + to_string(fields.size()) + " fields instead of " + to_string(nbFields);
+			return false;
+		}
+		for (int f = 0; f < nbFields; f++)
+		{
+			if (academicToggle == 0 && f == 7)
+				continue;
+			if (fields[f].empty() || fields[f].size() > 9 || fields[f].find_first_not_of("0123456789") != string::npos)
+			{
+				error = "line " + to_string(lineNumber) + " field " + to_string(f + 1) + " is not a non-negative integer of at most 9 digits";
+				return false;
+			}
+		}
+
+		int width = atoi(fields[0].c_str());
+		int depth = atoi(fields[1].c_str());
+		int height = atoi(fields[2].c_str());
+		if (width <= 0 || depth <= 0 || height <= 0)
+		{
+			error = "line " + to_string(lineNumber) + " has an empty dimension";
+			return false;
+		}
+		if (height > BinHeight || !((width <= BinWidth && depth <= BinDepth) || (depth <= BinWidth && width <= BinDepth)))
+		{
+			error = "line " + to_string(lineNumber) + " does not fit in a bin in any orientation";
+			return false;
+		}
+
+		if (academicToggle == 0)
+		{
+			if (atoi(fields[3].c_str()) > maxBinWeight)
+			{
+				error = "line " + to_string(lineNumber) + " is heavier than the bin weight limit";
+				return false;
+			}
+			if (2 * atoi(fields[5].c_str()) >= width || 2 * atoi(fields[6].c_str()) >= depth)
+			{
+				error = "line " + to_string(lineNumber) + " has an edge reduce of at least half its width or depth";
+				return false;
+			}
+			const string &supportType = fields[7];
+			if (supportType != "FULL" && supportType != "ALL_EDGES" && supportType != "SHORT_EDGES" && supportType != "LONG_EDGES" && supportType != "CORNERS")
+			{
+				error = "line " + to_string(lineNumber) + " has the unknown support type " + supportType;
+				return false;
+			}
+		}
+
+		nbItems += atoi(fields[quantityField].c_str());
+		if (nbItems > maxRequestItems)
+		{
+			error = "the instance has more than " + to_string(maxRequestItems) + " items";
+			return false;
+		}
+		items += line + "\n";
+	}
+
+	if (nbItems == 0)
+	{
+		error = "the instance has no items";
+		return false;
+	}
+	return true;
+}
+
+/**
+Answer a request
+@param the connection and the request
+@return false if the daemon must stop
+*/
+bool handleRequest(int connection, const string &request)
+{
+	size_t lineEnd = request.find('\n');
+	string command = request.substr(0, lineEnd);
+	if (command.size() > 0 && command.back() == '\r')
+		command.pop_back();
+
+	if (command == "PING")
+	{
+		sendLine(connection, "PONG");
+		return true;
+	}
+	if (command == "SHUTDOWN")
+	{
+		sendLine(connection, "BYE");
+		return false;
+	}
+	if (command.compare(0, 6, "SOLVE ") != 0 || command.size() == 6)
+	{
+		sendLine(connection, "ERROR unknown request, expected SOLVE <instance name>, PING or SHUTDOWN");
+		return true;
+	}
+
+	string instanceName = command.substr(6);
+	size_t payloadEnd = request.find("\nEND", lineEnd - 1);
+	string items, error;
+	if (!checkItemLines(request.substr(lineEnd + 1, payloadEnd - lineEnd), items, error))
+	{
+		sendLine(connection, "ERROR " + error);
+		return true;
+	}
+
+	//The solution is written to the connection through its own stream, closing it leaves the connection open
+	FILE *output = fdopen(dup(connection), "wb");
+	if (output == NULL)
+	{
+		sendLine(connection, "ERROR could not open the connection for writing");
+		return true;
+	}
+
+	istringstream itemStream(items);
+	SolveStats stats = solveInstance(instanceName, itemStream, output, BinSink());
+	fclose(output);
+
+	cout << instanceName << "\tItems: " << stats.nbItems << "\tTime: " << stats.seconds << " s\tBins: " << stats.nbBins << "\tUnplaced: " << stats.nbUnplacedItems << endl;
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	string socketPath = "/tmp/binpacking3d.sock";
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--socket" && i + 1 < argc)
+			socketPath = argv[++i];
+		else
+		{
+			cout << "Usage: SolverDaemon [--socket path]" << endl;
+			return 1;
+		}
+	}
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path))
+	{
+		cout << "The socket path is too long: " << socketPath << endl;
+		return 1;
+	}
+	strcpy(address.sun_path, socketPath.c_str());
+
+	//A client that goes away must not stop the daemon, its writes just fail
+	signal(SIGPIPE, SIG_IGN);
+
+	//Set up the state that the requests share: parameters, the thread pool and the CPLEX environment
+	setUpParameters();
+	getThreadPool();
+#ifndef NO_CPLEX
+	masterEnvironment();
+#endif
+
+	//Only the owner of the daemon can connect to the socket
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socketPath.c_str());
+	mode_t previousMask = umask(0177);
+	bool bound = listener >= 0 && bind(listener, (sockaddr*)&address, sizeof(address)) == 0;
+	umask(previousMask);
+	if (!bound || listen(listener, 64) != 0)
+	{
+		cout << "Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+		return 1;
+	}
+	cout << "Listening on " << socketPath << endl;
+
+	bool running = true;
+	string request;
+	while (running)
+	{
+		int connection = accept(listener, NULL, NULL);
+		if (connection < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cout << "Could not accept a connection: " << strerror(errno) << endl;
+			break;
+		}
+
+		//A client that stops sending or reading must not stall the requests behind it
+		timeval timeout;
+		timeout.tv_sec = connectionTimeout;
+		timeout.tv_usec = 0;
+		setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		if (readRequest(connection, request))
+			running = handleRequest(connection, request);
+		else
+			sendLine(connection, "ERROR incomplete request");
+		close(connection);
+	}
+
+	close(listener);
+	unlink(socketPath.c_str());
+	return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef INSTANCEGENERATOR_H
+#define INSTANCEGENERATOR_H
+
+#include "Common.h"
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+//Item distribution of an instance class, item attributes are drawn uniformly from the ranges
+struct InstanceClass
+{
+	int minW, maxW, minD, maxD, minH, maxH;		//Dimension ranges in mm
+	int minWeight, maxWeight;					//Weight range in grams
+	int minLoadBearing, maxLoadBearing;			//Load bearing range (load cap is load bearing * w * d / 200)
+	int maxEdgeReduce;							//Max edge reduce width and depth
+	int minQuantity, maxQuantity;				//Range of the number of items of an item type
+	int linesPerSequence;						//Number of item types that share a planogram sequence number
+	double supportTypeShares[5];				//Shares of the FULL, ALL_EDGES, SHORT_EDGES, LONG_EDGES and CORNERS support types
+};
+
+//Instance classes, indexed from 1 as in the names of the generated instances
+//1: Small boxes		2: Medium boxes		3: Large boxes		4: Mixed sizes		5: Flat boxes
+vector<InstanceClass> instanceClasses = {
+	{ 100, 300, 100, 300, 50, 300, 200, 5000, 50, 200, 0, 1, 20, 10, { 1.0, 0, 0, 0, 0 } },
+	{ 200, 450, 200, 450, 100, 450, 1000, 15000, 50, 200, 10, 1, 12, 10, { 0.7, 0.1, 0.1, 0.1, 0 } },
+	{ 300, 600, 300, 800, 200, 800, 5000, 40000, 100, 300, 20, 1, 6, 5, { 0.6, 0.1, 0.1, 0.1, 0.1 } },
+	{ 100, 600, 100, 800, 50, 800, 200, 40000, 50, 300, 20, 1, 15, 10, { 0.6, 0.1, 0.1, 0.1, 0.1 } },
+	{ 200, 600, 200, 800, 50, 150, 500, 10000, 100, 300, 10, 1, 20, 10, { 0.8, 0.1, 0.1, 0, 0 } }
+};
+
+/**
+Create a directory if it does not exist yet
+@param the directory path
+*/
+void makeDirectory(const string &path)
+{
+#ifdef _WIN32
+	_mkdir(path.c_str());
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+/**
+Draw an integer uniformly from a range
+@param random number generator, and the bounds of the range
+@return the drawn value
+*/
+int drawUniform(mt19937 &generator, int minValue, int maxValue)
+{
+	return minValue + generator() % (maxValue - minValue + 1);
+}
+
+/**
+Generate an instance file under ../../Parameters, in the format that parseItems reads
+Practical format, one item type per line: w, d, h, weight, load bearing, edge reduce width, edge reduce depth, support type, quantity, planogram sequence
+Academic format, one item type per line: w, d, h, quantity
+@param the instance name (the file path under ../../Parameters without the .txt extension), the instance class (from 1), the number of items, the random seed, and whether the academic format is used
+@return false if the class does not exist or the file could not be written
+*/
+bool generateInstance(const string &instanceName, int classIndex, int nbItems, unsigned seed, bool academic)
+{
+	if (classIndex < 1 || classIndex > instanceClasses.size())
+		return false;
+
+	const InstanceClass &instanceClass = instanceClasses[classIndex - 1];
+	const char *supportTypes[5] = { "FULL", "ALL_EDGES", "SHORT_EDGES", "LONG_EDGES", "CORNERS" };
+	mt19937 generator(seed);
+
+	makeDirectory("../../Parameters");
+	ofstream file("../../Parameters/" + instanceName + ".txt");
+	if (!file.is_open())
+		return false;
+
+	int nbGenerated = 0;
+	int line = 0;
+	while (nbGenerated < nbItems)
+	{
+		int quantity = min(drawUniform(generator, instanceClass.minQuantity, instanceClass.maxQuantity), nbItems - nbGenerated);
+		int width = drawUniform(generator, instanceClass.minW, instanceClass.maxW);
+		int depth = drawUniform(generator, instanceClass.minD, instanceClass.maxD);
+		int height = drawUniform(generator, instanceClass.minH, instanceClass.maxH);
+
+		if (academic)
+			file << width << "\t" << depth << "\t" << height << "\t" << quantity << endl;
+		else
+		{
+			int weight = drawUniform(generator, instanceClass.minWeight, instanceClass.maxWeight);
+			int loadBearing = drawUniform(generator, instanceClass.minLoadBearing, instanceClass.maxLoadBearing);
+			int edgeReduce = drawUniform(generator, 0, instanceClass.maxEdgeReduce);
+
+			//Pick the support type by its share
+			double draw = (generator() % 1000000) / 1000000.0;
+			int supportType = 0;
+			for (double share = instanceClass.supportTypeShares[0]; supportType < 4 && draw >= share; share += instanceClass.supportTypeShares[supportType])
+				supportType++;
+
+			file << width << "\t" << depth << "\t" << height << "\t" << weight << "\t" << loadBearing << "\t" << edgeReduce << "\t" << edgeReduce << "\t" <<
+				supportTypes[supportType] << "\t" << quantity << "\t" << 1 + line / instanceClass.linesPerSequence << endl;
+		}
+
+		nbGenerated += quantity;
+		line++;
+	}
+
+	return true;
+}
+
+#endif
@@ -25,14 +25,15 @@ struct Item
 	vector<int> SIx, SIy, SIz, SIw, SId, SIh;	//Coordinates of the items in the super item (considering the front bottom left corner of the item is (0, 0, 0))
 	vector<int> supportedItems;		//List of items that support this item
 	vector<double> supportPercentages;		//Percentage of support for the supporting items (to calculate weight distribution)
+	SupportShape supportShapes[2];			//Support shapes of the footprint as is and rotated
 
 	//Default constructor
-	struct Item()
+	Item()
 	{
 	}
 
 	//Constructor
-	struct Item(int id, int seq, int W, int D, int H, int wgt, int lCap, int eRWidth, int eRDepth, string sptType)
+	Item(int id, int seq, int W, int D, int H, int wgt, int lCap, int eRWidth, int eRDepth, string sptType)
 	{
 		this->ID = id;
 		this->planogramSeq = seq;
@@ -82,10 +83,14 @@ struct Item
 			this->topSurfaceArea = supportArea;
 			this->loadCap = ((this->w * this->d) / supportArea) * this->loadCap;
 		}
+
+		//Precompute the support geometry of both orientations
+		this->supportShapes[0] = makeSupportShape(this->w, this->d, this->supportType, this->edgeReduceWidth, this->edgeReduceDepth);
+		this->supportShapes[1] = makeSupportShape(this->d, this->w, this->supportType, this->edgeReduceWidth, this->edgeReduceDepth);
 	}
 
 	//Simple constructor
-	struct Item(int W, int D, int H)
+	Item(int W, int D, int H)
 	{
 		this->w = W;
 		this->d = D;
@@ -129,6 +134,37 @@ struct Item
 		int temp = this->w;
 		this->w = this->d;
 		this->d = temp;
+		swap(this->supportShapes[0], this->supportShapes[1]);
+	}
+
+	/**
+	Get the support shape of the item for a placed footprint
+	@param the placed width-depth of the item
+	@return the support shape, built on the fly if the footprint is not one of the precomputed ones
+	*/
+	SupportShape placedSupportShape(int placedW, int placedD) const
+	{
+		for (int o = 0; o < 2; o++)
+		{
+			if (this->supportShapes[o].w == placedW && this->supportShapes[o].d == placedD)
+				return this->supportShapes[o];
+		}
+		return makeSupportShape(placedW, placedD, this->supportType, this->edgeReduceWidth, this->edgeReduceDepth);
+	}
+
+	/**
+	Calculates width-depth overlap between this item at the bottom and an item on top
+	@param x-y coordinates and placed width-depth of this item, and x-y coordinates and width-depth of the item on top
+	@return total overlap area value between items, based on the support shape of this item
+	*/
+	double supportOverlap(int x1, int y1, int w1, int d1, int x2, int y2, int w2, int d2) const
+	{
+		for (int o = 0; o < 2; o++)
+		{
+			if (this->supportShapes[o].w == w1 && this->supportShapes[o].d == d1)
+				return calculateOverlap(this->supportShapes[o], x1, y1, x2, y2, w2, d2);
+		}
+		return calculateOverlap(x1, y1, w1, d1, x2, y2, w2, d2, this->supportType, this->edgeReduceWidth, this->edgeReduceDepth);
 	}
 
 	//Main sorting operator
@@ -218,16 +254,13 @@ bool sortItemsHorizontalArea(const Item &i1, const Item &i2)
 }
 
 /**
-Parses items in the input file
+Parses items from an input stream, one item type per line in the format of the instance files
 
-@param file name
+@param the input stream
 */
-void parseItems(string fileName)
+void parseItems(istream &input)
 {
-	//Get file location
-	ifstream myfile1;
-	myfile1.open("../../Parameters/" + fileName + ".txt");
-
+	PROFILE_SCOPE("parseItems");
 	string line;
 
 	size_t pos = 0;
@@ -239,11 +272,10 @@ void parseItems(string fileName)
 	vector<string> fields;
 
 	//Read data
-	for (myfile1; getline(myfile1, line);)
+	while (getline(input, line))
 	{
 		v.push_back(split(fields, line, delimiter));
 	}
-	myfile1.close();
 
 	int itemCount = 0;
 
@@ -337,11 +369,26 @@ void parseItems(string fileName)
 	remainingItemList = uniqueItemList;
 }
 
+/**
+Parses items in the input file
+
+@param file name
+*/
+void parseItems(string fileName)
+{
+	//Get file location
+	ifstream myfile1;
+	myfile1.open("../../Parameters/" + fileName + ".txt");
+	parseItems(myfile1);
+	myfile1.close();
+}
+
 /**
 Groups items and superitems into lists based on their heights so that they can be used in BuildLayer
 */
 void groupItems()
 {
+	PROFILE_SCOPE("groupItems");
 	vector<Item> groupElements;
 	vector<int> groupStartIndexList;
 
@@ -509,6 +556,7 @@ Generates super items
 */
 void generateSuperItems()
 {
+	PROFILE_SCOPE("generateSuperItems");
 	//Get the number of items from the remaining item list based on batch size
 	int currBatchSize;
 	if (planogramSeqToggle == 1)
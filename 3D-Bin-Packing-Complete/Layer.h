@@ -4,6 +4,70 @@
 #include "Item.h"
 #include "Common.h"
 
+//Items referenced by layers, stored once so that layers only keep their positions in the pool
+//A deque keeps references to pooled items valid while new items are added
+deque<Item> layerItemPool;
+unordered_multimap<int, int> layerItemPoolIndex;		//Positions of the pooled items with a given ID
+
+/**
+Checks if two items are the same, including the contents of super items
+@return true if the items are the same, false if they are not
+*/
+bool samePooledItem(const Item &i1, const Item &i2)
+{
+	if (i1.ID != i2.ID || i1.w != i2.w || i1.d != i2.d || i1.h != i2.h || i1.weight != i2.weight || i1.loadCap != i2.loadCap ||
+		i1.supportType != i2.supportType || i1.topSurfaceArea != i2.topSurfaceArea ||
+		i1.edgeReduceWidth != i2.edgeReduceWidth || i1.edgeReduceDepth != i2.edgeReduceDepth || i1.SIList.size() != i2.SIList.size())
+		return false;
+
+	for (int i = 0; i < i1.SIList.size(); i++)
+	{
+		if (i1.SIList[i].ID != i2.SIList[i].ID)
+			return false;
+	}
+
+	return i1.nbItemsInSILayer == i2.nbItemsInSILayer && i1.SIx == i2.SIx && i1.SIy == i2.SIy && i1.SIz == i2.SIz &&
+		i1.SIw == i2.SIw && i1.SId == i2.SId && i1.SIh == i2.SIh;
+}
+
+/**
+Find an item in the layer item pool without changing the pool, so that it can be called from parallel bin construction passes
+Super item IDs are reused by every batch, so a pooled item is only shared when its contents are the same
+@param an item object
+@return the position of the item in the pool, -1 if it is not pooled
+*/
+int findPooledItem(const Item &newItem)
+{
+	pair<unordered_multimap<int, int>::iterator, unordered_multimap<int, int>::iterator> range = layerItemPoolIndex.equal_range(newItem.ID);
+	for (unordered_multimap<int, int>::iterator it = range.first; it != range.second; it++)
+	{
+		if (samePooledItem(layerItemPool[it->second], newItem))
+			return it->second;
+	}
+	return -1;
+}
+
+/**
+Find an item in the layer item pool, adding it if it is not there yet. Not thread safe, the pool may only grow while no bin construction pass runs
+@param an item object
+@return the position of the item in the pool
+*/
+int poolItem(const Item &newItem)
+{
+	int index = findPooledItem(newItem);
+	if (index >= 0)
+		return index;
+
+	layerItemPool.push_back(newItem);
+	//Support information belongs to items placed in bins, layers do not need it
+	layerItemPool.back().supportedItems.clear();
+	layerItemPool.back().supportPercentages.clear();
+
+	index = layerItemPool.size() - 1;
+	layerItemPoolIndex.insert(make_pair(newItem.ID, index));
+	return index;
+}
+
 //Class definition for layers
 struct Layer
 {
@@ -11,39 +75,49 @@ struct Layer
 	int layerHeight;		//Height of the layer
 	double alpha;			//Decision variable value obtained from the mathematical model for the layer (column, in this case)
 	int weight;				//Total weight of the items in the layer
+	unsigned long long signature;	//Hash of the items and their positions, set when the layer is added to layerList
+	int agingCounter;		//Nb consecutive master solves in which the layer had positive reduced cost
+	bool aged;				//True if the layer is left out of the master LP, but kept for bin construction
 
-	vector<Item> itemList;	//List of items in the layer
+	vector<int> itemIndices;	//Positions of the items of the layer in layerItemPool
 	vector<int> orientationList;	//	0: if unchanged		1: if turned (in width-depth plane)
 	vector<int> xVec, yVec, zVec, wList, dList, hList;	//List of x, y, z coordinates (of front bottom left corners) and width, depth, height dimensions of items in the layer
 
 	//Default constructor
-	struct Layer()
+	Layer()
 	{
 		layerHeight = 0;
 		alpha = 0;
 		weight = 0;
+		signature = 0;
+		agingCounter = 0;
+		aged = false;
+	}
+
+	/**
+	@param the position of an item in the layer
+	@return the item object
+	*/
+	const Item &item(int index) const
+	{
+		return layerItemPool[this->itemIndices[index]];
 	}
 
-	//Destructor
-	~Layer()
+	/**
+	@return the number of items in the layer
+	*/
+	int nbItems() const
 	{
-		itemList.clear();
-		orientationList.clear();
-		xVec.clear();
-		yVec.clear();
-		zVec.clear();
-		wList.clear();
-		dList.clear();
-		hList.clear();
+		return this->itemIndices.size();
 	}
 
 	/**
 	Insert item into layer
 	@param an item object, the orientation by which it will be placed, and the x and y coordinates for the front bottom left corner of the item
 	*/
-	void insertItem(Item i, int orientation, int xCoord, int yCoord)
+	void insertItem(const Item &i, int orientation, int xCoord, int yCoord)
 	{
-		itemList.push_back(i);
+		itemIndices.push_back(poolItem(i));
 		orientationList.push_back(orientation);
 		xVec.push_back(xCoord);
 		yVec.push_back(yCoord);
@@ -53,9 +127,9 @@ struct Layer
 	Insert item into layer
 	@param an item object, coordinates of the front bottom left corner and the width, depth, height dimensions of the item
 	*/
-	void insertItem(Item i, int x, int y, int z, int w, int d, int h)
+	void insertItem(const Item &i, int x, int y, int z, int w, int d, int h)
 	{
-		itemList.push_back(i);
+		itemIndices.push_back(poolItem(i));
 		xVec.push_back(x);
 		yVec.push_back(y);
 		zVec.push_back(z);
@@ -70,7 +144,7 @@ struct Layer
 	*/
 	void deleteItem(int index)
 	{
-		itemList.erase(itemList.begin() + index);
+		itemIndices.erase(itemIndices.begin() + index);
 		orientationList.erase(orientationList.begin() + index);
 		xVec.erase(xVec.begin() + index);
 		yVec.erase(yVec.begin() + index);
@@ -80,25 +154,25 @@ struct Layer
 	Replace an item in the layer with another item
 	@param the index of the item in the layer to be replaced, the new item object, and the orientation by which it will be placed
 	*/
-	void replaceItem(int index, Item i, int orientation)
+	void replaceItem(int index, const Item &i, int orientation)
 	{
 		int width, depth;
 		if (orientationList[index] == 0)
 		{
-			width = itemList[index].w;
-			depth = itemList[index].d;
+			width = item(index).w;
+			depth = item(index).d;
 		}
 		else if (orientationList[index] == 1)
 		{
-			width = itemList[index].d;
-			depth = itemList[index].w;
+			width = item(index).d;
+			depth = item(index).w;
 		}
 		//Place the new item to center the deleted item
 		int x = (width - i.w) / 2;
 		int y = (depth - i.d) / 2;
 		xVec[index] = x;
 		yVec[index] = y;
-		itemList[index] = i;
+		itemIndices[index] = poolItem(i);
 		orientationList[index] = orientation;
 	}
 
@@ -109,12 +183,12 @@ struct Layer
 	{
 		double coveredSpace = 0;
 
-		for (int i = 0; i < this->itemList.size(); i++)
+		for (int i = 0; i < this->nbItems(); i++)
 		{
 			if (academicToggle == 1)
-				coveredSpace += this->itemList[i].w * this->itemList[i].d;
+				coveredSpace += this->item(i).w * this->item(i).d;
 			else
-				coveredSpace += this->itemList[i].topSurfaceArea;
+				coveredSpace += this->item(i).topSurfaceArea;
 				//coveredSpace += itemList[i].w * itemList[i].d;
 			
 		}
@@ -124,35 +198,53 @@ struct Layer
 			this->layerOccupancy = (coveredSpace / (BinWidth * BinDepth)) * 100;
 	}
 
+	/**
+	Find the pool position of an item of a super item, adding it to the pool if it is not there yet and no parallel loop runs
+	Inside the parallel bin construction passes growing the pool would race with the other passes, so the items must be pooled before with poolSuperItemParts,
+	and a missing item is an error in every build
+	@param an item of a super item in the layer
+	@return the position of the item in the pool
+	*/
+	static int pooledSuperItemPart(const Item &part)
+	{
+		int index = findPooledItem(part);
+		if (index >= 0)
+			return index;
+
+		if (insideParallelRegion)
+			throw logic_error("Layer::unpack: item " + to_string(part.ID) + " of a super item is not pooled, call poolSuperItemParts before the parallel passes");
+		return poolItem(part);
+	}
+
 	/**
 	Unpack super items so that every item is singular in the layer, and orientation check is not needed for items
 	*/
 	void unpack()
 	{
 		//Create new vectors for the coordinates, item list and dimensions
-		vector<Item> newItemList;
+		vector<int> newItemIndices;
 		vector<int> newxVec, newyVec, newzVec, newwList, newdList, newhList;
 
-		for (int i = 0; i < this->itemList.size(); i++)
+		for (int i = 0; i < this->nbItems(); i++)
 		{
 			//If the item is not a super item
-			if (this->itemList[i].SIList.size() == 0)
+			if (this->item(i).SIList.size() == 0)
 			{
-				newItemList.push_back(this->itemList[i]);
+				newItemIndices.push_back(this->itemIndices[i]);
 				newxVec.push_back(this->xVec[i]);
 				newyVec.push_back(this->yVec[i]);
 				newzVec.push_back(0);
-				newhList.push_back(this->itemList[i].h);
+				newhList.push_back(this->item(i).h);
 				if (this->orientationList[i] == 0)
 				{
-					newwList.push_back(this->itemList[i].w);
-					newdList.push_back(this->itemList[i].d);
+					newwList.push_back(this->item(i).w);
+					newdList.push_back(this->item(i).d);
 				}
 				//If the item is turned, update the dimensions
 				else
 				{
-					newwList.push_back(this->itemList[i].d);
-					newdList.push_back(this->itemList[i].w);
+					newwList.push_back(this->item(i).d);
+					newdList.push_back(this->item(i).w);
 				}
 			}
 			//If the item is a super item
@@ -160,26 +252,26 @@ struct Layer
 			{
 				int itemCt = 0;
 				//Loop through the layers of items in the super item
-				for (int j = 0; j < this->itemList[i].nbItemsInSILayer.size(); j++)
+				for (int j = 0; j < this->item(i).nbItemsInSILayer.size(); j++)
 				{
 					//If the layer in the super item has only 1 item
-					if (this->itemList[i].nbItemsInSILayer[j] == 1)
+					if (this->item(i).nbItemsInSILayer[j] == 1)
 					{
-						newItemList.push_back(this->itemList[i].SIList[itemCt]);
-						newxVec.push_back(this->xVec[i] + this->itemList[i].SIx[itemCt]);
-						newyVec.push_back(this->yVec[i] + this->itemList[i].SIy[itemCt]);
-						newzVec.push_back(this->itemList[i].SIz[itemCt]);
-						newhList.push_back(this->itemList[i].SIh[itemCt]);
+						newItemIndices.push_back(pooledSuperItemPart(this->item(i).SIList[itemCt]));
+						newxVec.push_back(this->xVec[i] + this->item(i).SIx[itemCt]);
+						newyVec.push_back(this->yVec[i] + this->item(i).SIy[itemCt]);
+						newzVec.push_back(this->item(i).SIz[itemCt]);
+						newhList.push_back(this->item(i).SIh[itemCt]);
 						if (this->orientationList[i] == 0)
 						{
-							newwList.push_back(this->itemList[i].SIw[itemCt]);
-							newdList.push_back(this->itemList[i].SId[itemCt]);
+							newwList.push_back(this->item(i).SIw[itemCt]);
+							newdList.push_back(this->item(i).SId[itemCt]);
 						}
 						//If the item is turned, update the dimensions
 						else
 						{
-							newwList.push_back(this->itemList[i].SId[itemCt]);
-							newdList.push_back(this->itemList[i].SIw[itemCt]);
+							newwList.push_back(this->item(i).SId[itemCt]);
+							newdList.push_back(this->item(i).SIw[itemCt]);
 						}
 						itemCt++;
 					}
@@ -188,61 +280,61 @@ struct Layer
 					{
 						if (this->orientationList[i] == 0)
 						{
-							for (int k = 0; k < this->itemList[i].nbItemsInSILayer[j]; k++)
+							for (int k = 0; k < this->item(i).nbItemsInSILayer[j]; k++)
 							{
-								newwList.push_back(this->itemList[i].SIw[itemCt]);
-								newdList.push_back(this->itemList[i].SId[itemCt]);
-								newhList.push_back(this->itemList[i].SIh[itemCt]);
-								newxVec.push_back(this->xVec[i] + this->itemList[i].SIx[itemCt]);
-								newyVec.push_back(this->yVec[i] + this->itemList[i].SIy[itemCt]);
-								newzVec.push_back(this->itemList[i].SIz[itemCt]);
-								newItemList.push_back(this->itemList[i].SIList[itemCt]);
+								newwList.push_back(this->item(i).SIw[itemCt]);
+								newdList.push_back(this->item(i).SId[itemCt]);
+								newhList.push_back(this->item(i).SIh[itemCt]);
+								newxVec.push_back(this->xVec[i] + this->item(i).SIx[itemCt]);
+								newyVec.push_back(this->yVec[i] + this->item(i).SIy[itemCt]);
+								newzVec.push_back(this->item(i).SIz[itemCt]);
+								newItemIndices.push_back(pooledSuperItemPart(this->item(i).SIList[itemCt]));
 								itemCt++;
 							}
 						}
 						if (this->orientationList[i] == 1)
 						{
 							int flbW, flbD;
-							for (int k = 0; k < this->itemList[i].nbItemsInSILayer[j]; k++)
+							for (int k = 0; k < this->item(i).nbItemsInSILayer[j]; k++)
 							{
-								if (this->itemList[i].SIx[itemCt] == 0 && this->itemList[i].SIy[itemCt] == 0)
+								if (this->item(i).SIx[itemCt] == 0 && this->item(i).SIy[itemCt] == 0)
 								{
 									newxVec.push_back(this->xVec[i]);
 									newyVec.push_back(this->yVec[i]);
-									newzVec.push_back(this->itemList[i].SIz[itemCt]);
-									newwList.push_back(this->itemList[i].SId[itemCt]);
-									newdList.push_back(this->itemList[i].SIw[itemCt]);
-									newhList.push_back(this->itemList[i].SIh[itemCt]);
-									flbW = this->itemList[i].SId[itemCt]; flbD = this->itemList[i].SIw[itemCt];
+									newzVec.push_back(this->item(i).SIz[itemCt]);
+									newwList.push_back(this->item(i).SId[itemCt]);
+									newdList.push_back(this->item(i).SIw[itemCt]);
+									newhList.push_back(this->item(i).SIh[itemCt]);
+									flbW = this->item(i).SId[itemCt]; flbD = this->item(i).SIw[itemCt];
 								}
-								else if (this->itemList[i].SIx[itemCt] > 0 && this->itemList[i].SIy[itemCt] == 0)
+								else if (this->item(i).SIx[itemCt] > 0 && this->item(i).SIy[itemCt] == 0)
 								{
 									newxVec.push_back(this->xVec[i]);
 									newyVec.push_back(this->yVec[i] + flbD);
-									newzVec.push_back(this->itemList[i].SIz[itemCt]);
-									newwList.push_back(this->itemList[i].SId[itemCt]);
-									newdList.push_back(this->itemList[i].SIw[itemCt]);
-									newhList.push_back(this->itemList[i].SIh[itemCt]);
+									newzVec.push_back(this->item(i).SIz[itemCt]);
+									newwList.push_back(this->item(i).SId[itemCt]);
+									newdList.push_back(this->item(i).SIw[itemCt]);
+									newhList.push_back(this->item(i).SIh[itemCt]);
 								}
-								else if (this->itemList[i].SIx[itemCt] == 0 && this->itemList[i].SIy[itemCt] > 0)
+								else if (this->item(i).SIx[itemCt] == 0 && this->item(i).SIy[itemCt] > 0)
 								{
 									newxVec.push_back(this->xVec[i] + flbW);
 									newyVec.push_back(this->yVec[i]);
-									newzVec.push_back(this->itemList[i].SIz[itemCt]);
-									newwList.push_back(this->itemList[i].SId[itemCt]);
-									newdList.push_back(this->itemList[i].SIw[itemCt]);
-									newhList.push_back(this->itemList[i].SIh[itemCt]);
+									newzVec.push_back(this->item(i).SIz[itemCt]);
+									newwList.push_back(this->item(i).SId[itemCt]);
+									newdList.push_back(this->item(i).SIw[itemCt]);
+									newhList.push_back(this->item(i).SIh[itemCt]);
 								}
-								else if (this->itemList[i].SIx[itemCt] > 0 && this->itemList[i].SIy[itemCt] > 0)
+								else if (this->item(i).SIx[itemCt] > 0 && this->item(i).SIy[itemCt] > 0)
 								{
 									newxVec.push_back(this->xVec[i] + flbW);
 									newyVec.push_back(this->yVec[i] + flbD);
-									newzVec.push_back(this->itemList[i].SIz[itemCt]);
-									newwList.push_back(this->itemList[i].SId[itemCt]);
-									newdList.push_back(this->itemList[i].SIw[itemCt]);
-									newhList.push_back(this->itemList[i].SIh[itemCt]);
+									newzVec.push_back(this->item(i).SIz[itemCt]);
+									newwList.push_back(this->item(i).SId[itemCt]);
+									newdList.push_back(this->item(i).SIw[itemCt]);
+									newhList.push_back(this->item(i).SIh[itemCt]);
 								}
-								newItemList.push_back(this->itemList[i].SIList[itemCt]);
+								newItemIndices.push_back(pooledSuperItemPart(this->item(i).SIList[itemCt]));
 								itemCt++;
 							}
 						}//if (curLayer.orientationList[i] == 1)
@@ -250,14 +342,65 @@ struct Layer
 				}
 			}
 
-		}//for (int i = 0; i < this->itemList.size(); i++)
-		this->itemList = newItemList; this->xVec = newxVec; this->yVec = newyVec; this->zVec = newzVec; this->wList = newwList; this->dList = newdList; this->hList = newhList;
-		newItemList.clear(); newxVec.clear(); newyVec.clear(); newzVec.clear(); newwList.clear(); newdList.clear(); newhList.clear();
+		}//for (int i = 0; i < this->nbItems(); i++)
+		this->itemIndices = newItemIndices; this->xVec = newxVec; this->yVec = newyVec; this->zVec = newzVec; this->wList = newwList; this->dList = newdList; this->hList = newhList;
+		newItemIndices.clear(); newxVec.clear(); newyVec.clear(); newzVec.clear(); newwList.clear(); newdList.clear(); newhList.clear();
+
+		for (int i = 0; i < nbItems(); i++)
+		{
+			weight += item(i).weight;
+		}
+	}
+
+	/**
+	@return the approximate memory used by the layer in bytes, excluding the pooled items
+	*/
+	size_t memoryUsage() const
+	{
+		return sizeof(Layer) + sizeof(int) * (this->itemIndices.capacity() + this->orientationList.capacity() + this->xVec.capacity() +
+			this->yVec.capacity() + this->zVec.capacity() + this->wList.capacity() + this->dList.capacity() + this->hList.capacity());
+	}
+
+	/**
+	Encode every item of the layer as its ID, coordinates and orientation, sorted so that the order of insertion does not matter
+	Coordinates are assumed to be smaller than 32768
+	@return the sorted item codes
+	*/
+	vector<unsigned long long> canonicalItems() const
+	{
+		vector<unsigned long long> codes(this->nbItems());
+
+		for (int i = 0; i < this->nbItems(); i++)
+		{
+			codes[i] = ((unsigned long long)this->item(i).ID << 32) | ((unsigned long long)this->xVec[i] << 17) |
+				((unsigned long long)this->yVec[i] << 1) | (unsigned long long)this->orientationList[i];
+		}
+		sort(codes.begin(), codes.end());
+
+		return codes;
+	}
+
+	/**
+	Calculate the 64-bit signature of the layer from its canonical item codes
+	@return the signature
+	*/
+	unsigned long long calculateSignature() const
+	{
+		vector<unsigned long long> codes = canonicalItems();
+		unsigned long long hash = 1469598103934665603ULL;
 
-		for (int i = 0; i < itemList.size(); i++)
+		for (int i = 0; i < codes.size(); i++)
 		{
-			weight += itemList[i].weight;
+			//Mix the code before combining it so that close coordinates spread over all bits
+			unsigned long long code = codes[i] + 0x9E3779B97F4A7C15ULL;
+			code = (code ^ (code >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			code = (code ^ (code >> 27)) * 0x94D049BB133111EBULL;
+			code = code ^ (code >> 31);
+
+			hash = (hash ^ code) * 1099511628211ULL;
 		}
+
+		return hash;
 	}
 
 	/**
@@ -274,48 +417,105 @@ struct Layer
 //Layer lists
 vector<Layer> layerList;			//Generated layer list
 vector<Layer> selectedLayerList;
+unordered_map<unsigned long long, int> layerSignatureIndex;	//Position of the layer with a given signature in layerList
+deque<Layer> coldLayerList;			//Columns purged from the master LP but still considered by bin construction, the longest purged first
+
+/**
+Pool the items of the super items of layers, so that unpacking the layers only reads the layer item pool
+@param a list of layers that are not unpacked yet
+*/
+void poolSuperItemParts(const vector<Layer> &layers)
+{
+	for (int i = 0; i < layers.size(); i++)
+	{
+		for (int j = 0; j < layers[i].nbItems(); j++)
+		{
+			for (int k = 0; k < layers[i].item(j).SIList.size(); k++)
+				poolItem(layers[i].item(j).SIList[k]);
+		}
+	}
+}
 
 /**
-Checks if two layers are exactly the same within the main layerList
+Checks if two layers are exactly the same, regardless of the order of their items
 @return true if the layers are the same, false if they are not
 */
 bool checkDuplicate(const Layer &l1, const Layer &l2)
 {
-	if (l1.itemList.size() != l2.itemList.size())
+	if (l1.nbItems() != l2.nbItems())
 		return false;
 
-	for (int i = 0; i < l1.itemList.size(); i++)
-	{
-		if (l1.itemList[i].ID != l2.itemList[i].ID)
-			return false;
-		if (l1.xVec[i] != l2.xVec[i])
-			return false;
-		if (l1.yVec[i] != l2.yVec[i])
-			return false;
-	}
+	return l1.canonicalItems() == l2.canonicalItems();
+}
+
+/**
+Add a layer to the main layerList, unless the same layer is already in it
+@param a layer object
+@return true if the layer is added
+*/
+bool addLayer(const Layer &newLayer)
+{
+	unsigned long long signature = newLayer.calculateSignature();
+
+	unordered_map<unsigned long long, int>::iterator it = layerSignatureIndex.find(signature);
+	if (it != layerSignatureIndex.end() && checkDuplicate(layerList[it->second], newLayer))
+		return false;
+
+	layerSignatureIndex[signature] = layerList.size();
+	layerList.push_back(newLayer);
+	layerList.back().signature = signature;
 
 	return true;
 }
 
 /**
-Removes duplicate layers from the main layerList
+Removes duplicate layers from the main layerList and rebuilds the signature index
+Layers may have been changed since they were added, so their signatures are calculated again
 */
 void removeDuplicateLayers()
 {
-	for (int i = 0; i < layerList.size() - 1; i++)
+	layerSignatureIndex.clear();
+	int nbUnique = 0;
+
+	for (int i = 0; i < layerList.size(); i++)
 	{
-		for (int j = i + 1; j < layerList.size(); j++)
-		{
-			if (checkDuplicate(layerList[i], layerList[j]))
-			{
-				Layer tempLayer = layerList.back();
-				layerList.back() = layerList[j];
-				layerList[j] = tempLayer;
-				layerList.pop_back();
-				j--;
-			}
-		}
+		unsigned long long signature = layerList[i].calculateSignature();
+
+		unordered_map<unsigned long long, int>::iterator it = layerSignatureIndex.find(signature);
+		if (it != layerSignatureIndex.end() && checkDuplicate(layerList[it->second], layerList[i]))
+			continue;
+
+		if (nbUnique != i)
+			swap(layerList[nbUnique], layerList[i]);
+		layerList[nbUnique].signature = signature;
+		layerSignatureIndex[signature] = nbUnique;
+		nbUnique++;
 	}
+
+	layerList.resize(nbUnique);
+}
+
+/**
+Rebuild the signature index of layerList without removing or moving layers, so that the positions stay aligned with the columns of the master LP
+*/
+void rebuildLayerSignatureIndex()
+{
+	layerSignatureIndex.clear();
+	for (int i = 0; i < layerList.size(); i++)
+	{
+		layerList[i].signature = layerList[i].calculateSignature();
+		layerSignatureIndex.insert(make_pair(layerList[i].signature, i));
+	}
+}
+
+/**
+Move the columns purged from the column pool back to layerList for bin construction, the ones that were generated again since they were purged are dropped
+*/
+void restoreColdLayers()
+{
+	for (int k = 0; k < coldLayerList.size(); k++)
+		addLayer(coldLayerList[k]);
+	coldLayerList.clear();
 }
 
 /**
@@ -338,21 +538,21 @@ bool sortLayersLoadCap(const Layer &l1, const Layer &l2)
 	double lC1 = 0; double lC2 = 0;
 
 	//Calculate average load cap of the items in both layers
-	for (int i = 0; i < l1.itemList.size(); i++)
+	for (int i = 0; i < l1.nbItems(); i++)
 	{
-		/*if (l1.itemList[i].loadCap < lC1)
-			lC1 = l1.itemList[i].loadCap;*/
-		lC1 += l1.itemList[i].loadCap;
+		/*if (l1.item(i).loadCap < lC1)
+			lC1 = l1.item(i).loadCap;*/
+		lC1 += l1.item(i).loadCap;
 	}
-	for (int i = 0; i < l2.itemList.size(); i++)
+	for (int i = 0; i < l2.nbItems(); i++)
 	{
-		/*if (l2.itemList[i].loadCap < lC2)
-			lC2 = l2.itemList[i].loadCap;*/
-		lC2 += l2.itemList[i].loadCap;
+		/*if (l2.item(i).loadCap < lC2)
+			lC2 = l2.item(i).loadCap;*/
+		lC2 += l2.item(i).loadCap;
 	}
 
-	lC1 /= l1.itemList.size();
-	lC2 /= l2.itemList.size();
+	lC1 /= l1.nbItems();
+	lC2 /= l2.nbItems();
 	
 	if (lC1 > lC2 && (l1.layerOccupancy > 0.9 * l2.layerOccupancy))
 		return true;
@@ -372,23 +572,29 @@ Layer rotateLayer(const Layer &currLayer)
 	Layer newLayer;
 	newLayer = currLayer;
 
-	for (int i = 0; i < currLayer.itemList.size(); i++)
+	for (int i = 0; i < currLayer.nbItems(); i++)
 	{
 		if (currLayer.orientationList[i] == 0)
 		{
-			newLayer.xVec[i] = BinWidth - (newLayer.xVec[i] + newLayer.itemList[i].w);
-			newLayer.yVec[i] = BinDepth - (newLayer.yVec[i] + newLayer.itemList[i].d);
+			newLayer.xVec[i] = BinWidth - (newLayer.xVec[i] + newLayer.item(i).w);
+			newLayer.yVec[i] = BinDepth - (newLayer.yVec[i] + newLayer.item(i).d);
 		}
 		else
 		{
-			newLayer.xVec[i] = BinWidth - (newLayer.xVec[i] + newLayer.itemList[i].d);
-			newLayer.yVec[i] = BinDepth - (newLayer.yVec[i] + newLayer.itemList[i].w);
+			newLayer.xVec[i] = BinWidth - (newLayer.xVec[i] + newLayer.item(i).d);
+			newLayer.yVec[i] = BinDepth - (newLayer.yVec[i] + newLayer.item(i).w);
 		}
 	}
 
 	return newLayer;
 }
 
+//Pricing results of the last generateLayers call
+double lastLayerReducedCost;			//Reduced cost of the last layer built by BuildLayer
+int lastLayerHeight;					//Height of the last layer built by BuildLayer
+vector<double> groupReducedCosts;		//Most negative reduced cost found for every item group
+vector<double> groupReducedCostRatios;	//Smallest reduced cost to height ratio found for every item group
+
 /**
 Build a layer using the Maxrects heuristic
 @param group of similar height items, iteration number, layer type, and the Maxrects heuristic number to be used (check main parameters)
@@ -396,6 +602,7 @@ Build a layer using the Maxrects heuristic
 */
 bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int heuristicNb)
 {
+	PROFILE_SCOPE("BuildLayer");
 	using namespace rbp;
 	bool result = false;
 
@@ -415,15 +622,15 @@ bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int h
 			continue;
 
 		//Check if the item already exists in the layer
-		for (int j = 0; j < newLayer.itemList.size(); j++)
+		for (int j = 0; j < newLayer.nbItems(); j++)
 		{
 			//If the item compared in the layer is a normal item
-			if (newLayer.itemList[j].SIList.size() == 0)
+			if (newLayer.item(j).SIList.size() == 0)
 			{
 				//If the new item is a normal item
 				if (newItem.SIList.size() == 0)
 				{
-					if (newItem.ID == newLayer.itemList[j].ID)
+					if (newItem.ID == newLayer.item(j).ID)
 					{
 						match = true;
 						break;
@@ -434,7 +641,7 @@ bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int h
 				{
 					for (int k = 0; k < newItem.SIList.size(); k++)
 					{
-						if (newItem.SIList[k].ID == newLayer.itemList[j].ID)
+						if (newItem.SIList[k].ID == newLayer.item(j).ID)
 						{
 							match = true;
 							break;
@@ -451,14 +658,14 @@ bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int h
 				//If the new item is a normal item
 				if (newItem.SIList.size() == 0)
 				{
-					for (int k = 0; k < newLayer.itemList[j].SIList.size(); k++)
+					for (int k = 0; k < newLayer.item(j).SIList.size(); k++)
 					{
-						if (newItem.ID == newLayer.itemList[j].SIList[k].ID)
+						if (newItem.ID == newLayer.item(j).SIList[k].ID)
 						{
 							match = true;
 							break;
 						}
-					}//for (int k = 0; k < superItems[newLayer.itemList[j] - uniqueItemList.size()].superItemList.size(); k++)
+					}//for (int k = 0; k < superItems[newLayer.item(j) - uniqueItemList.size()].superItemList.size(); k++)
 
 					if (match == true)
 						break;
@@ -468,14 +675,14 @@ bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int h
 				{
 					for (int k = 0; k < newItem.SIList.size(); k++)
 					{
-						for (int l = 0; l < newLayer.itemList[j].SIList.size(); l++)
+						for (int l = 0; l < newLayer.item(j).SIList.size(); l++)
 						{
-							if (newItem.SIList[k].ID == newLayer.itemList[j].SIList[l].ID)
+							if (newItem.SIList[k].ID == newLayer.item(j).SIList[l].ID)
 							{
 								match = true;
 								break;
 							}
-						}//for (int l = 0; l < superItems[newLayer.itemList[j] - uniqueItemList.size()].superItemList.size(); l++)
+						}//for (int l = 0; l < superItems[newLayer.item(j) - uniqueItemList.size()].superItemList.size(); l++)
 						if (match == true)
 							break;
 					}//for (int k = 0; k < superItems[newItem.ID - uniqueItemList.size()].superItemList.size(); k++)
@@ -483,7 +690,7 @@ bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int h
 						break;
 				}
 			}
-		}//for (int j = 0; j < newLayer.itemList.size(); j++)
+		}//for (int j = 0; j < newLayer.nbItems(); j++)
 
 		if (match == true)
 			continue;
@@ -526,13 +733,217 @@ bool BuildLayer(vector<Item> itemsToPack, int iteration, string layerType, int h
 	}
 
 	reducedCost = newLayer.layerHeight - reducedCost;
+	lastLayerReducedCost = reducedCost;
+	lastLayerHeight = newLayer.layerHeight;
 	if (iteration == 1 || reducedCost < 0)
+		result = addLayer(newLayer);
+
+	return result;
+}
+
+/**
+Check if none of the unique items in an item (or in a super item) are marked
+@param an item object and the marks of the unique items
+@return true if no unique item in the item is marked
+*/
+bool itemIDsFree(const Item &curItem, const vector<bool> &markedIDs)
+{
+	if (curItem.SIList.size() == 0)
+		return !markedIDs[curItem.ID];
+
+	for (int i = 0; i < curItem.SIList.size(); i++)
 	{
-		result = true;
-		layerList.push_back(newLayer);
+		if (markedIDs[curItem.SIList[i].ID])
+			return false;
 	}
+	return true;
+}
 
-	return result;
+/**
+Mark the unique items in an item (or in a super item)
+@param an item object and the marks of the unique items
+*/
+void markItemIDs(const Item &curItem, vector<bool> &markedIDs)
+{
+	if (curItem.SIList.size() == 0)
+		markedIDs[curItem.ID] = true;
+
+	for (int i = 0; i < curItem.SIList.size(); i++)
+		markedIDs[curItem.SIList[i].ID] = true;
+}
+
+/**
+Select items for a strip with a 0-1 knapsack DP over the width, on a grid of pricingGridStep
+@param item widths and values, and the list the indices of the selected items are written to
+@return the total value of the selected items
+*/
+double stripKnapsack(const vector<int> &widths, const vector<double> &values, vector<int> &selected)
+{
+	int capacity = BinWidth / pricingGridStep;
+	int nbCandidates = widths.size();
+
+	vector<double> bestValue(capacity + 1, 0);
+	vector<vector<bool>> taken(nbCandidates, vector<bool>(capacity + 1, false));
+
+	for (int i = 0; i < nbCandidates; i++)
+	{
+		//Round up so that the selected items fit into the real width
+		int weight = (widths[i] + pricingGridStep - 1) / pricingGridStep;
+		for (int c = capacity; c >= weight; c--)
+		{
+			if (bestValue[c - weight] + values[i] > bestValue[c])
+			{
+				bestValue[c] = bestValue[c - weight] + values[i];
+				taken[i][c] = true;
+			}
+		}
+	}
+
+	selected.clear();
+	int c = capacity;
+	for (int i = nbCandidates - 1; i >= 0; i--)
+	{
+		if (taken[i][c])
+		{
+			selected.push_back(i);
+			c -= (widths[i] + pricingGridStep - 1) / pricingGridStep;
+		}
+	}
+	reverse(selected.begin(), selected.end());
+
+	return bestValue[capacity];
+}
+
+/**
+Build a layer with a two-stage guillotine pattern for pricing: items are packed into strips across the width with a knapsack DP, and strips are stacked along the depth, best value per depth first
+The value of an item is its dual value, so the layer aims at the most negative reduced cost
+@param the items that can be packed
+@return true if a layer with negative reduced cost is added to the layer list
+*/
+bool BuildGuillotineLayer(const vector<Item> &itemsToPack)
+{
+	PROFILE_SCOPE("BuildGuillotineLayer");
+	Layer newLayer;
+	vector<bool> usedIDs(uniqueItemList.size(), false);
+	vector<bool> usedItems(itemsToPack.size(), false);
+	double dualValue = 0;
+	int stripY = 0;
+
+	//Strip depths are taken from the item sides
+	vector<int> stripDepths;
+	for (int i = 0; i < itemsToPack.size(); i++)
+	{
+		if (itemsToPack[i].reducedCost <= 0)
+			continue;
+		stripDepths.push_back(itemsToPack[i].w);
+		stripDepths.push_back(itemsToPack[i].d);
+	}
+	sort(stripDepths.begin(), stripDepths.end());
+	stripDepths.erase(unique(stripDepths.begin(), stripDepths.end()), stripDepths.end());
+
+	vector<int> candidates, orientations, widths, selected;
+	vector<double> values;
+
+	while (true)
+	{
+		double bestScore = 0;
+		int bestDepth = 0;
+		vector<int> bestItems, bestOrientations;
+
+		for (int s = 0; s < stripDepths.size(); s++)
+		{
+			int depth = stripDepths[s];
+			if (stripY + depth > BinDepth)
+				break;
+
+			//Items that fit into the strip, turned to the narrower width that fits
+			candidates.clear();
+			orientations.clear();
+			widths.clear();
+			values.clear();
+			for (int i = 0; i < itemsToPack.size(); i++)
+			{
+				const Item &curItem = itemsToPack[i];
+				if (usedItems[i] || curItem.reducedCost <= 0 || !itemIDsFree(curItem, usedIDs))
+					continue;
+
+				int orientation = -1;
+				if (curItem.d <= depth && curItem.w <= BinWidth)
+					orientation = 0;
+				if (curItem.w <= depth && curItem.d <= BinWidth && (orientation == -1 || curItem.d < curItem.w))
+					orientation = 1;
+				if (orientation == -1)
+					continue;
+
+				candidates.push_back(i);
+				orientations.push_back(orientation);
+				widths.push_back(orientation == 0 ? curItem.w : curItem.d);
+				values.push_back(curItem.reducedCost);
+			}
+			if (candidates.size() == 0)
+				continue;
+
+			stripKnapsack(widths, values, selected);
+
+			//Super items and their items cannot be in the same layer, keep the first of conflicting selections
+			vector<bool> stripIDs = usedIDs;
+			vector<int> stripItems, stripOrientations;
+			double stripValue = 0;
+			int stripDepth = 0;
+			for (int k = 0; k < selected.size(); k++)
+			{
+				const Item &curItem = itemsToPack[candidates[selected[k]]];
+				if (!itemIDsFree(curItem, stripIDs))
+					continue;
+				markItemIDs(curItem, stripIDs);
+
+				stripItems.push_back(candidates[selected[k]]);
+				stripOrientations.push_back(orientations[selected[k]]);
+				stripValue += curItem.reducedCost;
+				stripDepth = max(stripDepth, orientations[selected[k]] == 0 ? curItem.d : curItem.w);
+			}
+
+			if (stripDepth > 0 && stripValue / stripDepth > bestScore)
+			{
+				bestScore = stripValue / stripDepth;
+				bestDepth = stripDepth;
+				bestItems = stripItems;
+				bestOrientations = stripOrientations;
+			}
+		}
+
+		if (bestItems.size() == 0)
+			break;
+
+		//Place the strip
+		int stripX = 0;
+		for (int k = 0; k < bestItems.size(); k++)
+		{
+			const Item &curItem = itemsToPack[bestItems[k]];
+			newLayer.insertItem(curItem, bestOrientations[k], stripX, stripY);
+			stripX += bestOrientations[k] == 0 ? curItem.w : curItem.d;
+
+			usedItems[bestItems[k]] = true;
+			markItemIDs(curItem, usedIDs);
+			dualValue += curItem.reducedCost;
+			if (curItem.h > newLayer.layerHeight)
+				newLayer.layerHeight = curItem.h;
+		}
+		stripY += bestDepth;
+	}
+
+	if (newLayer.nbItems() == 0)
+		return false;
+
+	newLayer.calculateLayerOccupancy();
+
+	double reducedCost = newLayer.layerHeight - dualValue;
+	lastLayerReducedCost = reducedCost;
+	lastLayerHeight = newLayer.layerHeight;
+	if (reducedCost < 0)
+		return addLayer(newLayer);
+
+	return false;
 }
 
 /**
@@ -586,15 +997,32 @@ void generateInitialLayers()
 	}
 }
 
+/**
+Keep the most negative reduced cost and reduced cost to height ratio of the layers built for an item group
+@param the index of the item group
+*/
+void recordPricing(int group)
+{
+	if (lastLayerReducedCost < groupReducedCosts[group])
+		groupReducedCosts[group] = lastLayerReducedCost;
+
+	if (lastLayerHeight > 0 && lastLayerReducedCost / lastLayerHeight < groupReducedCostRatios[group])
+		groupReducedCostRatios[group] = lastLayerReducedCost / lastLayerHeight;
+}
+
 /**
 Generate layers for column generation
 @param layer type (not relevant anymore)
 */
 bool generateLayers(string layerType)
 {
+	PROFILE_SCOPE("generateLayers");
 	bool result = false;
 	bool overallResult = false;
 
+	groupReducedCosts.assign(itemGroups.size(), 0);
+	groupReducedCostRatios.assign(itemGroups.size(), 0);
+
 	if (layerType == "normal")
 	{
 		for (int i = 0; i < itemGroups.size(); i++)
@@ -622,10 +1050,21 @@ bool generateLayers(string layerType)
 					result = BuildLayer(groupCopy, 2, "normal", j);
 					if (result == true)
 						overallResult = true;
+					recordPricing(i);
 				}
 			}
 			else
+			{
 				result = BuildLayer(groupCopy, 2, "normal", MAXRECTSHeuristic);
+				recordPricing(i);
+			}
+
+			//If the MaxRects pre-pass finds no layer with negative reduced cost, use the guillotine DP generator
+			if (pricingEngine == 1 && groupReducedCosts[i] >= 0)
+			{
+				result = BuildGuillotineLayer(groupCopy);
+				recordPricing(i);
+			}
 
 			groupCopy.clear();
 
@@ -671,36 +1110,36 @@ void constructAdditionalLayers(int heuristicNb)
 			heuristic = rbp::MaxRectsBinPack::RectBottomLeftRule;
 
 		//Place every item in the layer again
-		for (int j = 0; j < curLayer.itemList.size(); j++)
+		for (int j = 0; j < curLayer.nbItems(); j++)
 		{
 			int itemWidth, itemDepth, itemHeight;
 			if (curLayer.orientationList[j] == 0)
 			{
-				itemWidth = curLayer.itemList[j].w;
-				itemDepth = curLayer.itemList[j].d;
+				itemWidth = curLayer.item(j).w;
+				itemDepth = curLayer.item(j).d;
 			}
 			else if (curLayer.orientationList[j] == 1)
 			{
-				itemWidth = curLayer.itemList[j].d;
-				itemDepth = curLayer.itemList[j].w;
+				itemWidth = curLayer.item(j).d;
+				itemDepth = curLayer.item(j).w;
 			}
-			itemHeight = curLayer.itemList[j].h;
+			itemHeight = curLayer.item(j).h;
 
 			rbp::Rect packedRect = bin.Insert(itemWidth, itemDepth, heuristic);
 
 			if (packedRect.height > 0)
 			{
-				if (curLayer.itemList[j].w == packedRect.width)
-					newLayer.insertItem(curLayer.itemList[j], 0, packedRect.x, packedRect.y);
-				else if (curLayer.itemList[j].w == packedRect.height)
-					newLayer.insertItem(curLayer.itemList[j], 1, packedRect.x, packedRect.y);
+				if (curLayer.item(j).w == packedRect.width)
+					newLayer.insertItem(curLayer.item(j), 0, packedRect.x, packedRect.y);
+				else if (curLayer.item(j).w == packedRect.height)
+					newLayer.insertItem(curLayer.item(j), 1, packedRect.x, packedRect.y);
 
 				if (itemHeight > newLayer.layerHeight)
 					newLayer.layerHeight = itemHeight;
 
 				newLayer.calculateLayerOccupancy();
 			}//if (packedRect.height > 0)
-		}//for (int j = 0; j < curLayer.itemList.size(); j++)
+		}//for (int j = 0; j < curLayer.nbItems(); j++)
 
 		 //Try to place unselected items
 		for (int j = 0; j < itemList.size(); j++)
@@ -708,9 +1147,9 @@ void constructAdditionalLayers(int heuristicNb)
 			Item curItem = itemList[j];
 			int check = 0;
 
-			for (int k = 0; k < curLayer.itemList.size(); k++)
+			for (int k = 0; k < curLayer.nbItems(); k++)
 			{
-				if (curItem.ID == curLayer.itemList[k].ID)
+				if (curItem.ID == curLayer.item(k).ID)
 				{
 					check = 1;
 					break;
@@ -750,11 +1189,11 @@ void constructAdditionalLayers(int heuristicNb)
 			Item currentSI = superItems[j];
 			int check = 0;
 
-			for (int k = 0; k < curLayer.itemList.size(); k++)
+			for (int k = 0; k < curLayer.nbItems(); k++)
 			{
 				for (int l = 0; l < currentSI.SIList.size(); l++)
 				{
-					if (curLayer.itemList[k].ID == currentSI.SIList[l].ID)
+					if (curLayer.item(k).ID == currentSI.SIList[l].ID)
 					{
 						check = 1;
 						break;
@@ -792,7 +1231,7 @@ void constructAdditionalLayers(int heuristicNb)
 			}//if (packedRect.height > 0)
 		}//for (int j = 0; j < superItems.size(); j++)
 
-		layerList.push_back(curLayer);
+		addLayer(curLayer);
 	}
 }
 
@@ -804,16 +1243,17 @@ void rotateLayers()
 	int layerListSize = layerList.size();
 	for (int i = 0; i < layerListSize; i++)
 	{
-		layerList.push_back(rotateLayer(layerList[i]));
+		addLayer(rotateLayer(layerList[i]));
 	}
 }
 
+#ifndef NO_CPLEX
 //CPLEX model builder for the main column generation
 void buildModelByColumn(IloModel mod,
 	IloNumVarArray alpha,
 	const IloInt nUniqueItems,
 	const IloInt nNormalColumns,
-	const vector<Layer> normalLayers,
+	const vector<Layer> &normalLayers,
 	IloNumVar::Type type,
 	IloRangeArray range,
 	IloObjective cost)
@@ -835,20 +1275,143 @@ void buildModelByColumn(IloModel mod,
 		alpha.add(IloNumVar(col, 0, 1, type));
 		col.end();
 
-		for (int i = 0; i < normalLayers[k].itemList.size(); i++)
+		for (int i = 0; i < normalLayers[k].nbItems(); i++)
 		{
-			if (normalLayers[k].itemList[i].SIList.size() == 0)
-				range[normalLayers[k].itemList[i].ID].setLinearCoef(alpha[k], 1);
+			if (normalLayers[k].item(i).SIList.size() == 0)
+				range[normalLayers[k].item(i).ID].setLinearCoef(alpha[k], 1);
 			else
 			{
-				for (int j = 0; j < normalLayers[k].itemList[i].SIList.size(); j++)
+				for (int j = 0; j < normalLayers[k].item(i).SIList.size(); j++)
 				{
-					range[normalLayers[k].itemList[i].SIList[j].ID].setLinearCoef(alpha[k], 1);
+					range[normalLayers[k].item(i).SIList[j].ID].setLinearCoef(alpha[k], 1);
 				}
 			}
 		}
 	}
 }
+#endif
+
+/**
+Put every layer back into the master LP, used when the master model is built again for a new batch
+*/
+void resetColumnPool()
+{
+	for (int k = 0; k < layerList.size(); k++)
+	{
+		layerList[k].agingCounter = 0;
+		layerList[k].aged = false;
+	}
+}
+
+/**
+The layer item pool is not counted, it is only freed at the end of an instance, so purging columns cannot make it smaller
+@return the approximate memory used by the columns in layerList and coldLayerList in bytes
+*/
+size_t columnPoolMemory()
+{
+	size_t memory = 0;
+	for (int k = 0; k < layerList.size(); k++)
+		memory += layerList[k].memoryUsage();
+	for (int k = 0; k < coldLayerList.size(); k++)
+		memory += coldLayerList[k].memoryUsage();
+
+	return memory;
+}
+
+#ifndef NO_CPLEX
+/**
+Age the columns of the master problem after it is solved
+Columns with positive reduced cost in columnAgingLimit consecutive solves leave the LP (their upper bound is set to 0), but stay in layerList for bin construction
+Aged columns come back when their reduced cost turns negative. If the pool is above its memory limit, the aged columns that left the LP longest ago are purged
+from the LP and layerList into coldLayerList, which bin construction still considers, and the longest purged columns are dropped from coldLayerList until the pool is within the limit.
+@param the solved CPLEX object, the column variables, and the iteration number
+*/
+void manageColumnPool(IloCplex &cplex, IloNumVarArray &alpha, int iteration)
+{
+	IloNumArray reducedCosts(cplex.getEnv());
+	cplex.getReducedCosts(reducedCosts, alpha);
+
+	int nbAged = 0;
+	for (int k = 0; k < layerList.size(); k++)
+	{
+		if (reducedCosts[k] > 1e-6)
+			layerList[k].agingCounter++;
+		else
+			layerList[k].agingCounter = 0;
+
+		if (columnAgingLimit > 0 && !layerList[k].aged && layerList[k].agingCounter >= columnAgingLimit)
+		{
+			layerList[k].aged = true;
+			alpha[k].setUB(0);
+		}
+		else if (layerList[k].aged && reducedCosts[k] < -1e-6)
+		{
+			layerList[k].aged = false;
+			alpha[k].setUB(1);
+		}
+
+		if (layerList[k].aged)
+			nbAged++;
+	}
+	reducedCosts.end();
+
+	//Purge aged columns, longest aged first, until the columns left in the LP are within the memory limit
+	size_t memory = columnPoolMemory();
+	size_t memoryLimit = (size_t)columnPoolMemoryLimit * 1024 * 1024;
+	int nbPurged = 0;
+	int nbDropped = 0;
+	if (memory > memoryLimit && nbAged > 0)
+	{
+		//The cold columns are dropped below, so they do not count against the LP
+		for (int k = 0; k < coldLayerList.size(); k++)
+			memory -= coldLayerList[k].memoryUsage();
+
+		vector<pair<int, int>> agedColumns;
+		for (int k = 0; k < layerList.size(); k++)
+		{
+			if (layerList[k].aged)
+				agedColumns.push_back(make_pair(-layerList[k].agingCounter, k));
+		}
+		sort(agedColumns.begin(), agedColumns.end());
+
+		vector<bool> purge(layerList.size(), false);
+		for (int i = 0; i < agedColumns.size() && memory > memoryLimit; i++)
+		{
+			purge[agedColumns[i].second] = true;
+			memory -= layerList[agedColumns[i].second].memoryUsage();
+			nbPurged++;
+		}
+
+		//Remove the columns from the back so that alpha and layerList stay aligned
+		for (int k = layerList.size() - 1; k >= 0; k--)
+		{
+			if (!purge[k])
+				continue;
+			alpha[k].end();
+			alpha.remove(k);
+			coldLayerList.push_back(std::move(layerList[k]));
+			coldLayerList.back().alpha = 0;
+			layerList.erase(layerList.begin() + k);
+		}
+
+		//Positions changed, so rebuild the signature index
+		rebuildLayerSignatureIndex();
+	}
+
+	//Drop the longest purged columns until the pool, in and out of the LP, is within its memory limit
+	memory = columnPoolMemory();
+	while (memory > memoryLimit && coldLayerList.size() > 0)
+	{
+		memory -= coldLayerList.front().memoryUsage();
+		coldLayerList.pop_front();
+		nbDropped++;
+	}
+
+	if (columnPoolLogToggle == 1)
+		cout << "Iteration " << iteration << "\tColumns: " << layerList.size() << "\tIn LP: " << layerList.size() - nbAged + nbPurged <<
+			"\tAged: " << nbAged - nbPurged << "\tPurged: " << nbPurged << "\tCold: " << coldLayerList.size() << "\tDropped: " << nbDropped <<
+			"\tPool memory (MB): " << memory / (1024.0 * 1024.0) << endl;
+}
 
 //CPLEX model builder for the previous layer spacing implementation
 void buildModelByRow(IloModel mod,
@@ -857,7 +1420,7 @@ void buildModelByRow(IloModel mod,
 	const vector<int> w,
 	const vector<int> d,
 	int nbItems,
-	Layer layer)
+	const Layer &layer)
 {
 	IloEnv env = mod.getEnv();
 
@@ -874,13 +1437,13 @@ void buildModelByRow(IloModel mod,
 		int w, d;
 		if (layer.orientationList[i] == 0)
 		{
-			w = layer.itemList[i].w;
-			d = layer.itemList[i].d;
+			w = layer.item(i).w;
+			d = layer.item(i).d;
 		}
 		else
 		{
-			w = layer.itemList[i].d;
-			d = layer.itemList[i].w;
+			w = layer.item(i).d;
+			d = layer.item(i).w;
 		}
 
 		int xStartCoord = layer.xVec[i];
@@ -897,13 +1460,13 @@ void buildModelByRow(IloModel mod,
 				int w2, d2;
 				if (layer.orientationList[j] == 0)
 				{
-					w2 = layer.itemList[j].w;
-					d2 = layer.itemList[j].d;
+					w2 = layer.item(j).w;
+					d2 = layer.item(j).d;
 				}
 				else
 				{
-					w2 = layer.itemList[j].d;
-					d2 = layer.itemList[j].w;
+					w2 = layer.item(j).d;
+					d2 = layer.item(j).w;
 				}
 				int nXStartCoord = layer.xVec[j];
 				int nXEndCoord = nXStartCoord + w2;
@@ -1060,7 +1623,7 @@ void buildModelByRowX(IloModel mod,
 	const vector<int> w,
 	const vector<int> d,
 	int nbItems,
-	Layer layer)
+	const Layer &layer)
 {
 	IloEnv env = mod.getEnv();
 
@@ -1076,13 +1639,13 @@ void buildModelByRowX(IloModel mod,
 		int w1, d1;
 		if (layer.orientationList[i] == 0)
 		{
-			w1 = layer.itemList[i].w;
-			d1 = layer.itemList[i].d;
+			w1 = layer.item(i).w;
+			d1 = layer.item(i).d;
 		}
 		else
 		{
-			w1 = layer.itemList[i].d;
-			d1 = layer.itemList[i].w;
+			w1 = layer.item(i).d;
+			d1 = layer.item(i).w;
 		}
 		int yStartCoord = layer.yVec[i];
 		int yEndCoord = yStartCoord + d1;
@@ -1095,13 +1658,13 @@ void buildModelByRowX(IloModel mod,
 				int w2, d2;
 				if (layer.orientationList[j] == 0)
 				{
-					w2 = layer.itemList[j].w;
-					d2 = layer.itemList[j].d;
+					w2 = layer.item(j).w;
+					d2 = layer.item(j).d;
 				}
 				else
 				{
-					w2 = layer.itemList[j].d;
-					d2 = layer.itemList[j].w;
+					w2 = layer.item(j).d;
+					d2 = layer.item(j).w;
 				}
 				int nYStartCoord = layer.yVec[j];
 				int nYEndCoord = nYStartCoord + d2;
@@ -1210,7 +1773,7 @@ void buildModelByRowY(IloModel mod,
 	const vector<int> w,
 	const vector<int> d,
 	int nbItems,
-	Layer layer)
+	const Layer &layer)
 {
 	IloEnv env = mod.getEnv();
 
@@ -1226,13 +1789,13 @@ void buildModelByRowY(IloModel mod,
 		int w1, d1;
 		if (layer.orientationList[i] == 0)
 		{
-			w1 = layer.itemList[i].w;
-			d1 = layer.itemList[i].d;
+			w1 = layer.item(i).w;
+			d1 = layer.item(i).d;
 		}
 		else
 		{
-			w1 = layer.itemList[i].d;
-			d1 = layer.itemList[i].w;
+			w1 = layer.item(i).d;
+			d1 = layer.item(i).w;
 		}
 		int xStartCoord = layer.xVec[i];
 		int xEndCoord = xStartCoord + w1;
@@ -1245,13 +1808,13 @@ void buildModelByRowY(IloModel mod,
 				int w2, d2;
 				if (layer.orientationList[j] == 0)
 				{
-					w2 = layer.itemList[j].w;
-					d2 = layer.itemList[j].d;
+					w2 = layer.item(j).w;
+					d2 = layer.item(j).d;
 				}
 				else
 				{
-					w2 = layer.itemList[j].d;
-					d2 = layer.itemList[j].w;
+					w2 = layer.item(j).d;
+					d2 = layer.item(j).w;
 				}
 				int nXStartCoord = layer.xVec[j];
 				int nXEndCoord = nXStartCoord + w2;
@@ -1371,8 +1934,8 @@ void CPLEXmaximizeSupportForLayers(IloModel mod,
 	const vector<int> w,
 	const vector<int> d,
 	int nbItems,
-	Layer bottomLayer,
-	Layer topLayer)
+	const Layer &bottomLayer,
+	const Layer &topLayer)
 {
 	IloEnv env = mod.getEnv();
 
@@ -1390,14 +1953,14 @@ void CPLEXmaximizeSupportForLayers(IloModel mod,
 
 	for (int i = 0; i < nbItems; i++)
 	{
-		xMax[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		xMin[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		yMax[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		yMin[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		xPos[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		yPos[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		overlapCount[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		for (int j = 0; j < bottomLayer.itemList.size(); j++)
+		xMax[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		xMin[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		yMax[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		yMin[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		xPos[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		yPos[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		overlapCount[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		for (int j = 0; j < bottomLayer.nbItems(); j++)
 		{
 			xMax[i][j] = IloNumVar(env, 0, BinWidth, ILOFLOAT);
 			xMin[i][j] = IloNumVar(env, 0, BinWidth, ILOFLOAT);
@@ -1411,7 +1974,7 @@ void CPLEXmaximizeSupportForLayers(IloModel mod,
 
 	for (int i = 0; i < nbItems; i++)
 	{
-		for (int j = 0; j < bottomLayer.itemList.size(); j++)
+		for (int j = 0; j < bottomLayer.nbItems(); j++)
 		{
 			sum += overlapCount[i][j];
 			//sum += xPos[i][j] * yPos[i][j];
@@ -1445,12 +2008,12 @@ void CPLEXmaximizeSupportForLayers(IloModel mod,
 			}
 		}
 
-		for (int j = 0; j < bottomLayer.itemList.size(); j++)
+		for (int j = 0; j < bottomLayer.nbItems(); j++)
 		{
 			if (bottomLayer.layerHeight - (bottomLayer.zVec[j] + bottomLayer.hList[j]) <= LayerHeightTolerance)
 			{
 				//if (calculateOverlap(bottomLayer.xVec[j], bottomLayer.yVec[j], bottomLayer.wList[j], bottomLayer.dList[j],
-				//	topLayer.xVec[i], topLayer.yVec[i], w[i], d[i], bottomLayer.itemList[j].supportType, bottomLayer.itemList[j].edgeReduceWidth, bottomLayer.itemList[j].edgeReduceDepth) > 0)
+				//	topLayer.xVec[i], topLayer.yVec[i], w[i], d[i], bottomLayer.item(j).supportType, bottomLayer.item(j).edgeReduceWidth, bottomLayer.item(j).edgeReduceDepth) > 0)
 				//{
 				//	mod.add(xMax[i][j] <= c[i][0] + w[i]);
 				//	mod.add(xMax[i][j] <= bottomLayer.xVec[j] + bottomLayer.wList[j]);
@@ -1502,8 +2065,8 @@ void CPLEXmaximizeSupportForLayersConstrained(IloModel mod,
 	const vector<int> w,
 	const vector<int> d,
 	int nbItems,
-	Layer bottomLayer,
-	Layer topLayer)
+	const Layer &bottomLayer,
+	const Layer &topLayer)
 {
 	IloEnv env = mod.getEnv();
 
@@ -1518,14 +2081,14 @@ void CPLEXmaximizeSupportForLayersConstrained(IloModel mod,
 
 	for (int i = 0; i < nbItems; i++)
 	{
-		xMax[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		xMin[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		yMax[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		yMin[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		xPos[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-		yPos[i] = IloNumVarArray(env, bottomLayer.itemList.size());
-
-		for (int j = 0; j < bottomLayer.itemList.size(); j++)
+		xMax[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		xMin[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		yMax[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		yMin[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		xPos[i] = IloNumVarArray(env, bottomLayer.nbItems());
+		yPos[i] = IloNumVarArray(env, bottomLayer.nbItems());
+
+		for (int j = 0; j < bottomLayer.nbItems(); j++)
 		{
 			xMax[i][j] = IloNumVar(env, 0, BinWidth, ILOFLOAT);
 			xMin[i][j] = IloNumVar(env, 0, BinWidth, ILOFLOAT);
@@ -1565,12 +2128,12 @@ void CPLEXmaximizeSupportForLayersConstrained(IloModel mod,
 
 		IloExpr expr10(env);
 
-		for (int j = 0; j < bottomLayer.itemList.size(); j++)
+		for (int j = 0; j < bottomLayer.nbItems(); j++)
 		{
 			if (bottomLayer.layerHeight - (bottomLayer.zVec[j] + bottomLayer.hList[j]) <= LayerHeightTolerance)
 			{
 				//if (calculateOverlap(bottomLayer.xVec[j], bottomLayer.yVec[j], bottomLayer.wList[j], bottomLayer.dList[j],
-				//	topLayer.xVec[i], topLayer.yVec[i], w[i], d[i], bottomLayer.itemList[j].supportType, bottomLayer.itemList[j].edgeReduceWidth, bottomLayer.itemList[j].edgeReduceDepth) > 0)
+				//	topLayer.xVec[i], topLayer.yVec[i], w[i], d[i], bottomLayer.item(j).supportType, bottomLayer.item(j).edgeReduceWidth, bottomLayer.item(j).edgeReduceDepth) > 0)
 				//{
 				//	mod.add(xMax[i][j] <= c[i][0] + w[i]);
 				//	mod.add(xMax[i][j] <= bottomLayer.xVec[j] + bottomLayer.wList[j]);
@@ -1620,7 +2183,360 @@ void CPLEXmaximizeSupportForLayersConstrained(IloModel mod,
 		expr9.end();
 	}
 }
+#endif
+
+//Cached result of a layer spacing model
+struct SpacingResult
+{
+	bool solved;			//False if the model could not be solved
+	vector<int> xVec, yVec;	//Spaced coordinates of the items in the top layer
+};
+
+//Layer spacing cache, keyed by the signatures of the bottom and the top layer (the bottom signature is empty for spaceLayer)
+map<pair<vector<int>, vector<int>>, SpacingResult> spacingCache;
+mutex spacingCacheMutex;		//Guards the cache, layers are spaced by parallel bin construction passes
+
+/**
+Build the signature of a layer that is about to be spaced, made of the dimensions and coordinates of its items
+@param a layer object that is not unpacked yet
+@return the signature
+*/
+vector<int> topLayerSignature(const Layer &curLayer)
+{
+	vector<int> signature;
+	signature.reserve(4 * curLayer.nbItems());
+
+	for (int i = 0; i < curLayer.nbItems(); i++)
+	{
+		if (curLayer.orientationList[i] == 0)
+		{
+			signature.push_back(curLayer.item(i).w);
+			signature.push_back(curLayer.item(i).d);
+		}
+		else
+		{
+			signature.push_back(curLayer.item(i).d);
+			signature.push_back(curLayer.item(i).w);
+		}
+		signature.push_back(curLayer.xVec[i]);
+		signature.push_back(curLayer.yVec[i]);
+	}
+
+	return signature;
+}
+
+/**
+Build the signature of a layer that is already placed in a bin, made of its height and the dimensions and coordinates of its items
+@param an unpacked layer object
+@return the signature
+*/
+vector<int> bottomLayerSignature(const Layer &curLayer)
+{
+	vector<int> signature;
+	signature.reserve(6 * curLayer.nbItems() + 1);
+
+	signature.push_back(curLayer.layerHeight);
+	for (int i = 0; i < curLayer.nbItems(); i++)
+	{
+		signature.push_back(curLayer.xVec[i]);
+		signature.push_back(curLayer.yVec[i]);
+		signature.push_back(curLayer.zVec[i]);
+		signature.push_back(curLayer.wList[i]);
+		signature.push_back(curLayer.dList[i]);
+		signature.push_back(curLayer.hList[i]);
+	}
+
+	return signature;
+}
+
+/**
+Look up a cached spacing result and apply it to the top layer
+@param the bottom and top layer signatures, the top layer, and the flag that is set to whether the cached model was solved
+@return true if the pair is in the cache
+*/
+bool lookupSpacing(const vector<int> &bottomSignature, const vector<int> &topSignature, Layer &topLayer, bool &solved)
+{
+	lock_guard<mutex> lock(spacingCacheMutex);
+	map<pair<vector<int>, vector<int>>, SpacingResult>::iterator it = spacingCache.find(make_pair(bottomSignature, topSignature));
+	if (it == spacingCache.end())
+		return false;
+
+	solved = it->second.solved;
+	if (solved)
+	{
+		topLayer.xVec = it->second.xVec;
+		topLayer.yVec = it->second.yVec;
+	}
+	return true;
+}
+
+/**
+Store the spacing result of a top layer in the cache
+@param the bottom and top layer signatures, whether the model was solved, and the spaced top layer
+*/
+void storeSpacing(const vector<int> &bottomSignature, const vector<int> &topSignature, bool solved, const Layer &topLayer)
+{
+	lock_guard<mutex> lock(spacingCacheMutex);
+	if (spacingCache.size() >= spacingCacheLimit)
+		spacingCache.clear();
+
+	SpacingResult result;
+	result.solved = solved;
+	if (solved)
+	{
+		result.xVec = topLayer.xVec;
+		result.yVec = topLayer.yVec;
+	}
+	spacingCache[make_pair(bottomSignature, topSignature)] = result;
+}
+
+/**
+Calculate the width and depth of the items in a layer that is not unpacked yet
+@param a layer object and the width and depth lists to be filled
+*/
+void orientedItemSizes(const Layer &curLayer, vector<int> &widths, vector<int> &depths)
+{
+	widths.resize(curLayer.nbItems());
+	depths.resize(curLayer.nbItems());
+
+	for (int i = 0; i < curLayer.nbItems(); i++)
+	{
+		if (curLayer.orientationList[i] == 0)
+		{
+			widths[i] = curLayer.item(i).w;
+			depths[i] = curLayer.item(i).d;
+		}
+		else
+		{
+			widths[i] = curLayer.item(i).d;
+			depths[i] = curLayer.item(i).w;
+		}
+	}
+}
+
+/**
+Sort item indices by increasing coordinate, which is a topological order of the precedence relations built from the same coordinates
+@param item coordinates and the index list to be filled
+*/
+void coordinateOrder(const vector<int> &coords, vector<int> &order)
+{
+	vector<pair<int, int>> sortedCoords;
+	for (int i = 0; i < coords.size(); i++)
+		sortedCoords.push_back(make_pair(coords[i], i));
+	sort(sortedCoords.begin(), sortedCoords.end());
+
+	order.resize(coords.size());
+	for (int i = 0; i < sortedCoords.size(); i++)
+		order[i] = sortedCoords[i].second;
+}
+
+/**
+Calculate the earliest and latest start coordinates of items in one dimension with longest paths over a precedence relation
+@param item sizes, items in topological order, precedence relation (before[i][j] is true if item i has to end before item j starts), the gap kept between consecutive items, the length of the dimension, and the earliest and latest coordinate lists to be filled
+@return true if every item fits between its earliest and latest coordinates
+*/
+bool longestPathBounds(const vector<int> &sizes, const vector<int> &order, const vector<vector<bool>> &before, int gap, int length, vector<int> &earliest, vector<int> &latest)
+{
+	int nbItems = sizes.size();
+	earliest.assign(nbItems, 0);
+	latest.assign(nbItems, 0);
+
+	for (int a = 0; a < nbItems; a++)
+	{
+		int i = order[a];
+		for (int b = 0; b < a; b++)
+		{
+			int p = order[b];
+			if (before[p][i] && earliest[p] + sizes[p] + gap > earliest[i])
+				earliest[i] = earliest[p] + sizes[p] + gap;
+		}
+	}
+
+	for (int a = nbItems - 1; a >= 0; a--)
+	{
+		int i = order[a];
+		latest[i] = length - sizes[i];
+		for (int b = a + 1; b < nbItems; b++)
+		{
+			int s = order[b];
+			if (before[i][s] && latest[s] - sizes[i] - gap < latest[i])
+				latest[i] = latest[s] - sizes[i] - gap;
+		}
+		if (latest[i] < earliest[i])
+			return false;
+	}
+
+	return true;
+}
+
+/**
+Spread items evenly in one dimension: find the largest gap that can be kept between all consecutive items, then center every item between its earliest and latest coordinates
+@param item sizes, item coordinates (updated), precedence relation, and the length of the dimension
+*/
+void spreadDimension(const vector<int> &sizes, vector<int> &coords, const vector<vector<bool>> &before, int length)
+{
+	vector<int> order, earliest, latest;
+	coordinateOrder(coords, order);
+
+	if (!longestPathBounds(sizes, order, before, 0, length, earliest, latest))
+		return;
+
+	//Binary search on the gap
+	int low = 0;
+	int high = length;
+	while (low < high)
+	{
+		int mid = (low + high + 1) / 2;
+		if (longestPathBounds(sizes, order, before, mid, length, earliest, latest))
+			low = mid;
+		else
+			high = mid - 1;
+	}
+	longestPathBounds(sizes, order, before, low, length, earliest, latest);
+
+	//The average of two feasible placements is feasible as well
+	for (int i = 0; i < coords.size(); i++)
+		coords[i] = (earliest[i] + latest[i]) / 2;
+}
+
+/**
+Space the bottom most layer in a bin with longest paths, without solving a model
+@param a layer object
+*/
+void spaceLayerCombinatorial(Layer &newLayer)
+{
+	int nbItems = newLayer.nbItems();
+	vector<int> widths, depths;
+	orientedItemSizes(newLayer, widths, depths);
+
+	vector<vector<bool>> before(nbItems, vector<bool>(nbItems, false));
+
+	//Spread in width dimension
+	for (int j = 0; j < nbItems; j++)
+		for (int k = 0; k < nbItems; k++)
+			before[j][k] = j != k && newLayer.xVec[j] + widths[j] <= newLayer.xVec[k];
+	spreadDimension(widths, newLayer.xVec, before, BinWidth);
+
+	//Spread in depth dimension
+	for (int j = 0; j < nbItems; j++)
+		for (int k = 0; k < nbItems; k++)
+			before[j][k] = j != k && newLayer.yVec[j] + depths[j] <= newLayer.yVec[k];
+	spreadDimension(depths, newLayer.yVec, before, BinDepth);
+}
+
+/**
+Move every item of a layer in one dimension, in increasing coordinate order, to the position that maximizes its overlap with the support rectangles while the other dimension stays fixed
+@param item sizes and coordinates (updated) in the moved dimension, item sizes and coordinates in the other dimension, support rectangle starts and sizes in both dimensions, and the length of the moved dimension
+*/
+void alignDimension(const vector<int> &sizes, vector<int> &coords, const vector<int> &crossSizes, const vector<int> &crossCoords,
+	const vector<int> &rectStarts, const vector<int> &rectSizes, const vector<int> &rectCrossStarts, const vector<int> &rectCrossSizes, int length)
+{
+	int nbItems = sizes.size();
+
+	//Only the items that are not separated in the other dimension have to keep their order
+	vector<vector<bool>> before(nbItems, vector<bool>(nbItems, false));
+	for (int j = 0; j < nbItems; j++)
+	{
+		for (int k = 0; k < nbItems; k++)
+		{
+			bool crossSeparated = crossCoords[j] + crossSizes[j] <= crossCoords[k] || crossCoords[k] + crossSizes[k] <= crossCoords[j];
+			before[j][k] = j != k && !crossSeparated && coords[j] + sizes[j] <= coords[k];
+		}
+	}
+
+	vector<int> order, earliest, latest;
+	coordinateOrder(coords, order);
+	if (!longestPathBounds(sizes, order, before, 0, length, earliest, latest))
+		return;
+
+	vector<int> crossOverlaps(rectStarts.size());
+	vector<int> candidates;
+
+	for (int a = 0; a < nbItems; a++)
+	{
+		int i = order[a];
+
+		//The item has to start after the items before it, which are already moved, and leave room for the items after it
+		int lowerBound = 0;
+		for (int b = 0; b < a; b++)
+		{
+			int p = order[b];
+			if (before[p][i] && coords[p] + sizes[p] > lowerBound)
+				lowerBound = coords[p] + sizes[p];
+		}
+		int upperBound = latest[i];
+
+		//Overlap breaks are at the edges of the support rectangles
+		candidates.clear();
+		candidates.push_back(coords[i]);
+		candidates.push_back(lowerBound);
+		candidates.push_back(upperBound);
+		for (int r = 0; r < rectStarts.size(); r++)
+		{
+			crossOverlaps[r] = min(crossCoords[i] + crossSizes[i], rectCrossStarts[r] + rectCrossSizes[r]) - max(crossCoords[i], rectCrossStarts[r]);
+			if (crossOverlaps[r] <= 0)
+				continue;
+			candidates.push_back(rectStarts[r]);
+			candidates.push_back(rectStarts[r] + rectSizes[r] - sizes[i]);
+			candidates.push_back(rectStarts[r] - sizes[i]);
+			candidates.push_back(rectStarts[r] + rectSizes[r]);
+		}
+
+		int bestCoord = coords[i];
+		long long bestArea = -1;
+		for (int c = 0; c < candidates.size(); c++)
+		{
+			int coord = min(max(candidates[c], lowerBound), upperBound);
+
+			long long area = 0;
+			for (int r = 0; r < rectStarts.size(); r++)
+			{
+				if (crossOverlaps[r] <= 0)
+					continue;
+				int overlap = min(coord + sizes[i], rectStarts[r] + rectSizes[r]) - max(coord, rectStarts[r]);
+				if (overlap > 0)
+					area += (long long)overlap * crossOverlaps[r];
+			}
+
+			//Prefer larger support, then smaller moves
+			if (area > bestArea || (area == bestArea && abs(coord - coords[i]) < abs(bestCoord - coords[i])))
+			{
+				bestArea = area;
+				bestCoord = coord;
+			}
+		}
+		coords[i] = bestCoord;
+	}
+}
+
+/**
+Space a layer so as to maximize its width-depth overlap with a bottom layer with alternating sweeps over both dimensions, without solving a model
+@param two layer objects: a bottom and a top layer
+*/
+void maximizeSupportCombinatorial(const Layer &bottomLayer, Layer &topLayer)
+{
+	vector<int> widths, depths;
+	orientedItemSizes(topLayer, widths, depths);
+
+	//Support rectangles are the items that reach the top of the bottom layer
+	vector<int> rectX, rectY, rectW, rectD;
+	for (int j = 0; j < bottomLayer.nbItems(); j++)
+	{
+		if (bottomLayer.layerHeight - (bottomLayer.zVec[j] + bottomLayer.hList[j]) <= LayerHeightTolerance)
+		{
+			rectX.push_back(bottomLayer.xVec[j]);
+			rectY.push_back(bottomLayer.yVec[j]);
+			rectW.push_back(bottomLayer.wList[j]);
+			rectD.push_back(bottomLayer.dList[j]);
+		}
+	}
 
+	for (int round = 0; round < 2; round++)
+	{
+		alignDimension(widths, topLayer.xVec, depths, topLayer.yVec, rectX, rectW, rectY, rectD, BinWidth);
+		alignDimension(depths, topLayer.yVec, widths, topLayer.xVec, rectY, rectD, rectX, rectW, BinDepth);
+	}
+}
 
 /**
 Space the bottom most layer in a bin, using the previous layer spacing implementation
@@ -1628,7 +2544,30 @@ Space the bottom most layer in a bin, using the previous layer spacing implement
 */
 void spaceLayer(Layer &newLayer)
 {
-	int nbItems = newLayer.itemList.size();
+	PROFILE_SCOPE("spaceLayer");
+	//Reuse the result if the same layer was spaced before
+	vector<int> layerSignature;
+	if (spacingCacheToggle == 1)
+	{
+		bool solved;
+		layerSignature = topLayerSignature(newLayer);
+		if (lookupSpacing(vector<int>(), layerSignature, newLayer, solved))
+			return;
+	}
+
+	if (spacingEngine != 0)
+	{
+		spaceLayerCombinatorial(newLayer);
+		if (spacingEngine == 1)
+		{
+			if (spacingCacheToggle == 1)
+				storeSpacing(vector<int>(), layerSignature, true, newLayer);
+			return;
+		}
+	}
+
+#ifndef NO_CPLEX
+	int nbItems = newLayer.nbItems();
 
 	vector<vector<vector<int>>> zPar;
 	vector<int> widths(nbItems, 0);
@@ -1649,31 +2588,31 @@ void spaceLayer(Layer &newLayer)
 		}
 	}
 
-	for (int j = 0; j < newLayer.itemList.size(); j++)
+	for (int j = 0; j < newLayer.nbItems(); j++)
 	{
 		int w1, d1, w2, d2;
 		if (newLayer.orientationList[j] == 0)
 		{
-			w1 = newLayer.itemList[j].w;
-			d1 = newLayer.itemList[j].d;
+			w1 = newLayer.item(j).w;
+			d1 = newLayer.item(j).d;
 		}
 		else
 		{
-			w1 = newLayer.itemList[j].d;
-			d1 = newLayer.itemList[j].w;
+			w1 = newLayer.item(j).d;
+			d1 = newLayer.item(j).w;
 		}
 
-		for (int k = 0; k < newLayer.itemList.size(); k++)
+		for (int k = 0; k < newLayer.nbItems(); k++)
 		{
 			if (newLayer.orientationList[k] == 0)
 			{
-				w2 = newLayer.itemList[k].w;
-				d2 = newLayer.itemList[k].d;
+				w2 = newLayer.item(k).w;
+				d2 = newLayer.item(k).d;
 			}
 			else
 			{
-				w2 = newLayer.itemList[k].d;
-				d2 = newLayer.itemList[k].w;
+				w2 = newLayer.item(k).d;
+				d2 = newLayer.item(k).w;
 			}
 
 			if (j != k && newLayer.xVec[j] + w1 <= newLayer.xVec[k])
@@ -1741,31 +2680,31 @@ void spaceLayer(Layer &newLayer)
 		}
 	}
 
-	for (int j = 0; j < newLayer.itemList.size(); j++)
+	for (int j = 0; j < newLayer.nbItems(); j++)
 	{
 		int w1, w2, d1, d2;
 		if (newLayer.orientationList[j] == 0)
 		{
-			w1 = newLayer.itemList[j].w;
-			d1 = newLayer.itemList[j].d;
+			w1 = newLayer.item(j).w;
+			d1 = newLayer.item(j).d;
 		}
 		else
 		{
-			w1 = newLayer.itemList[j].d;
-			d1 = newLayer.itemList[j].w;
+			w1 = newLayer.item(j).d;
+			d1 = newLayer.item(j).w;
 		}
 
-		for (int k = 0; k < newLayer.itemList.size(); k++)
+		for (int k = 0; k < newLayer.nbItems(); k++)
 		{
 			if (newLayer.orientationList[k] == 0)
 			{
-				w2 = newLayer.itemList[k].w;
-				d2 = newLayer.itemList[k].d;
+				w2 = newLayer.item(k).w;
+				d2 = newLayer.item(k).d;
 			}
 			else
 			{
-				w2 = newLayer.itemList[k].d;
-				d2 = newLayer.itemList[k].w;
+				w2 = newLayer.item(k).d;
+				d2 = newLayer.item(k).w;
 			}
 
 			if (j != k && newLayer.xVec[j] + w1 <= newLayer.xVec[k])
@@ -1826,6 +2765,9 @@ void spaceLayer(Layer &newLayer)
 		newLayer.yVec[j] = (int)cplexRPY.getValue(c2[j][1]);
 	}
 
+	if (spacingCacheToggle == 1)
+		storeSpacing(vector<int>(), layerSignature, true, newLayer);
+
 	zPar.clear();
 	widths2.clear();
 	depths2.clear();
@@ -1835,6 +2777,7 @@ void spaceLayer(Layer &newLayer)
 	cplexRP.end();
 	modRP.end();
 	envRP.end();
+#endif
 }
 
 /**
@@ -1843,9 +2786,33 @@ Space a layer so as to maximize its width-depth overlap with a bottom layer
 */
 bool maximizeSupport(Layer &bottomLayer, Layer &topLayer)
 {
+	PROFILE_SCOPE("maximizeSupport");
+	//Reuse the result if the same layer was spaced on the same bottom layer before
+	vector<int> bottomSignature, topSignature;
+	if (spacingCacheToggle == 1)
+	{
+		bool solved;
+		bottomSignature = bottomLayerSignature(bottomLayer);
+		topSignature = topLayerSignature(topLayer);
+		if (lookupSpacing(bottomSignature, topSignature, topLayer, solved))
+			return solved;
+	}
+
+	if (spacingEngine != 0)
+	{
+		maximizeSupportCombinatorial(bottomLayer, topLayer);
+		if (spacingEngine == 1)
+		{
+			if (spacingCacheToggle == 1)
+				storeSpacing(bottomSignature, topSignature, true, topLayer);
+			return true;
+		}
+	}
+
+#ifndef NO_CPLEX
 	int nbItems = 0;
 
-	nbItems = topLayer.itemList.size();
+	nbItems = topLayer.nbItems();
 
 	vector<vector<vector<int>>> zPar;
 	vector<int> widths(nbItems, 0);
@@ -1866,45 +2833,45 @@ bool maximizeSupport(Layer &bottomLayer, Layer &topLayer)
 		}
 	}
 
-	for (int j = 0; j < topLayer.itemList.size(); j++)
+	for (int j = 0; j < topLayer.nbItems(); j++)
 	{
 		int w1, d1, w2, d2, w3, d3;
 		if (topLayer.orientationList[j] == 0)
 		{
-			w1 = topLayer.itemList[j].w;
-			d1 = topLayer.itemList[j].d;
+			w1 = topLayer.item(j).w;
+			d1 = topLayer.item(j).d;
 		}
 		else
 		{
-			w1 = topLayer.itemList[j].d;
-			d1 = topLayer.itemList[j].w;
+			w1 = topLayer.item(j).d;
+			d1 = topLayer.item(j).w;
 		}
-		for (int k = 0; k < topLayer.itemList.size(); k++)
+		for (int k = 0; k < topLayer.nbItems(); k++)
 		{
 			if (topLayer.orientationList[k] == 0)
 			{
-				w2 = topLayer.itemList[k].w;
-				d2 = topLayer.itemList[k].d;
+				w2 = topLayer.item(k).w;
+				d2 = topLayer.item(k).d;
 			}
 			else
 			{
-				w2 = topLayer.itemList[k].d;
-				d2 = topLayer.itemList[k].w;
+				w2 = topLayer.item(k).d;
+				d2 = topLayer.item(k).w;
 			}
 			bool match = false;
-			for (int l = 0; l < topLayer.itemList.size(); l++)
+			for (int l = 0; l < topLayer.nbItems(); l++)
 			{
 				if (j == k || j == l || l == k)
 					continue;
 				if (topLayer.orientationList[l] == 0)
 				{
-					w3 = topLayer.itemList[l].w;
-					d3 = topLayer.itemList[l].d;
+					w3 = topLayer.item(l).w;
+					d3 = topLayer.item(l).d;
 				}
 				else
 				{
-					w3 = topLayer.itemList[l].d;
-					d3 = topLayer.itemList[l].w;
+					w3 = topLayer.item(l).d;
+					d3 = topLayer.item(l).w;
 				}
 				if (!(topLayer.yVec[l] > topLayer.yVec[j] + d1 || topLayer.yVec[l] + d3 < topLayer.yVec[j]) &&
 					!(topLayer.yVec[k] > topLayer.yVec[j] + d1 || topLayer.yVec[k] + d2 < topLayer.yVec[j]) &&
@@ -1962,7 +2929,13 @@ bool maximizeSupport(Layer &bottomLayer, Layer &topLayer)
 		IloCplex::SolutionOptimalGlobal);
 	//cplexRP.exportModel("model.mps");
 	if (!cplexRP.solve())
-		return false;
+	{
+		//Keep the combinatorial spacing if the refinement fails
+		bool solved = spacingEngine == 2;
+		if (spacingCacheToggle == 1)
+			storeSpacing(bottomSignature, topSignature, solved, topLayer);
+		return solved;
+	}
 
 	//std::cout << cplexRP.getStatus() << endl;
 
@@ -1972,6 +2945,9 @@ bool maximizeSupport(Layer &bottomLayer, Layer &topLayer)
 		topLayer.yVec[j] = (int)cplexRP.getValue(c[j][1]);
 	}
 
+	if (spacingCacheToggle == 1)
+		storeSpacing(bottomSignature, topSignature, true, topLayer);
+
 	zPar.clear();
 	widths.clear();
 	depths.clear();
@@ -1979,6 +2955,7 @@ bool maximizeSupport(Layer &bottomLayer, Layer &topLayer)
 	cplexRP.end();
 	modRP.end();
 	envRP.end();
+#endif
 	return true;
 }
 
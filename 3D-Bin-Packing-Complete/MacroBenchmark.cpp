@@ -0,0 +1,79 @@
+#include "Solver.h"
+#include "InstanceGenerator.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+//End-to-end benchmark that generates instances of increasing size and runs the full solver on them
+//Usage: MacroBenchmark [--class k] [--seed s] [--output file] [nb items ...]
+//Results are written as tab separated lines: instance, items, wall clock seconds, peak RSS (MB), bins, leftover items
+//Peak RSS is the peak of the process so far, so the sizes are run in increasing order
+
+/**
+@return the peak resident set size of the process in MB
+*/
+double peakMemoryMB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	int classIndex = 4;
+	unsigned seed = 1;
+	string outputFile = "MacroBenchmark.txt";
+	vector<int> sizes;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--class" && i + 1 < argc)
+			classIndex = atoi(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc)
+			seed = atoi(argv[++i]);
+		else if (arg == "--output" && i + 1 < argc)
+			outputFile = argv[++i];
+		else
+			sizes.push_back(atoi(arg.c_str()));
+	}
+	if (sizes.size() == 0)
+		sizes = { 200, 2000, 20000, 100000 };
+	sort(sizes.begin(), sizes.end());
+
+	setUpParameters();
+	makeDirectory("Results");
+
+	ofstream results(outputFile);
+	results << "Instance\tItems\tSeconds\tPeakRSSMB\tBins\tLeftovers" << endl;
+
+	for (int s = 0; s < sizes.size(); s++)
+	{
+		string instanceName = "MacroBenchmark_Class" + to_string(classIndex) + "_" + to_string(sizes[s]) + "Items";
+		if (!generateInstance(instanceName, classIndex, sizes[s], seed, academicToggle == 1))
+		{
+			cout << "Could not generate the instance " << instanceName << endl;
+			return 1;
+		}
+		makeDirectory("Results/" + instanceName);
+
+		SolveStats stats = solveInstance(instanceName);
+
+		results << instanceName << "\t" << stats.nbItems << "\t" << stats.seconds << "\t" << peakMemoryMB() << "\t" << stats.nbBins << "\t" << stats.nbLeftoverItems << endl;
+		cout << instanceName << "\tItems: " << stats.nbItems << "\tTime: " << stats.seconds << " s\tPeak RSS: " << peakMemoryMB() << " MB\tBins: " <<
+			stats.nbBins << "\tLeftovers: " << stats.nbLeftoverItems << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,441 @@
+#include "Common.h"
+#include "Item.h"
+#include "Layer.h"
+#include "Bin.h"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+//Micro benchmarks for the packing kernels on fixed seed synthetic inputs sized like the practical instances
+//Usage: MicroBenchmarks [--quick] [--output file] [--baseline file]
+//Results are written as tab separated lines: kernel, ns/op, allocations/op, ops/s
+//With a baseline file, kernels that are more than benchmarkTolerance slower than the baseline are reported and the exit code is 1, as it is when the baseline cannot be read
+//A baseline is the output file of a run on the same machine, see BINPACKING_BENCHMARK_BASELINE in CMakeLists.txt
+
+#define benchmarkTolerance 0.10			// Allowed relative ns/op increase over the baseline
+#define benchmarkSeed 12345				// Seed of the synthetic inputs
+#define benchmarkOrderSize 2000			// Nb items in the synthetic order
+#define benchmarkSlowOp 1e-5			// Operations slower than this (s) in the warm up are timed one by one instead of 64 at a time
+
+//Number of allocations made through operator new and operator new[]
+atomic<long long> allocationCount(0);
+
+//The deletes are kept out of line, otherwise GCC sees the free inside them called on the result of a new expression (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+void *operator new(size_t size)
+{
+	allocationCount++;
+	void *p = malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+		throw bad_alloc();
+	return p;
+}
+
+BENCHMARK_NOINLINE void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+BENCHMARK_NOINLINE void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+BENCHMARK_NOINLINE void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+BENCHMARK_NOINLINE void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+//Sink for kernel results, so that the compiler does not remove the measured work
+volatile double benchmarkSink = 0;
+
+//Measurements of a kernel
+struct BenchmarkResult
+{
+	string name;			//Kernel name
+	double nsPerOp;			//Wall clock time per operation in nanoseconds
+	double allocsPerOp;		//Heap allocations per operation
+	double opsPerSecond;	//Throughput
+};
+
+/**
+Run a kernel repeatedly until the minimum measurement time is reached
+@param kernel name, minimum measurement time in seconds, and the kernel, which runs one operation with the given operation number
+@return the measurements of the kernel
+*/
+template <typename Kernel>
+BenchmarkResult runBenchmark(const string &name, double minSeconds, Kernel kernel)
+{
+	//Warm up, at most for the minimum measurement time
+	int nbWarmUpOps = 0;
+	double warmUpStart = wallClock();
+	while (nbWarmUpOps < 10 && wallClock() - warmUpStart < minSeconds)
+		kernel(nbWarmUpOps++);
+
+	//Check the clock every 64 operations to keep its cost out of fast kernels, and after every operation of slow kernels so that they do not run far past the minimum time
+	int opsPerCheck = (wallClock() - warmUpStart) / nbWarmUpOps > benchmarkSlowOp ? 1 : 64;
+
+	long long nbOps = 0;
+	long long allocationsBefore = allocationCount;
+	double start = wallClock();
+	double elapsed = 0;
+	while (elapsed < minSeconds)
+	{
+		for (int i = 0; i < opsPerCheck; i++, nbOps++)
+			kernel(nbOps);
+		elapsed = wallClock() - start;
+	}
+	long long allocations = allocationCount - allocationsBefore;
+
+	BenchmarkResult result;
+	result.name = name;
+	result.nsPerOp = elapsed * 1e9 / nbOps;
+	result.allocsPerOp = (double)allocations / nbOps;
+	result.opsPerSecond = nbOps / elapsed;
+	return result;
+}
+
+/**
+Run a kernel repeatedly until the minimum measurement time is reached, with a setup before every operation that is not measured
+Every operation is timed on its own, so the kernel should take much longer than a clock read
+@param kernel name, minimum measurement time in seconds, the setup and the kernel, which are run with the given operation number
+@return the measurements of the kernel
+*/
+template <typename Setup, typename Kernel>
+BenchmarkResult runBenchmark(const string &name, double minSeconds, Setup setup, Kernel kernel)
+{
+	//Warm up
+	setup(0);
+	kernel(0);
+
+	long long nbOps = 0;
+	long long allocations = 0;
+	double elapsed = 0;
+	while (elapsed < minSeconds)
+	{
+		setup(nbOps);
+		long long allocationsBefore = allocationCount;
+		double start = wallClock();
+		kernel(nbOps);
+		elapsed += wallClock() - start;
+		allocations += allocationCount - allocationsBefore;
+		nbOps++;
+	}
+
+	BenchmarkResult result;
+	result.name = name;
+	result.nsPerOp = elapsed * 1e9 / nbOps;
+	result.allocsPerOp = (double)allocations / nbOps;
+	result.opsPerSecond = nbOps / elapsed;
+	return result;
+}
+
+/**
+Create a synthetic order in the unique and remaining item lists, with the item ranges of the practical instances
+@param the number of items and the random seed
+*/
+void generateBenchmarkOrder(int nbItems, unsigned seed)
+{
+	mt19937 generator(seed);
+	const char *supportTypes[5] = { "FULL", "ALL_EDGES", "SHORT_EDGES", "LONG_EDGES", "CORNERS" };
+
+	uniqueItemList.clear();
+	for (int i = 0; i < nbItems; i++)
+	{
+		int width = 150 + generator() % 350;
+		int depth = 150 + generator() % 350;
+		int height = 100 + (generator() % 8) * 50;
+		int weight = 1000 + generator() % 20000;
+		int loadCap = (50 + generator() % 150) * width * depth / 200;
+		int sequence = 1 + i / BatchSize;
+
+		shortestWD = min(shortestWD, min(width, depth));
+		shortestHeight = min(shortestHeight, height);
+		maxLoadCap = max(maxLoadCap, loadCap);
+		maxSeqNo = max(maxSeqNo, sequence);
+		totalVol += width * depth * height / 1000000;
+
+		uniqueItemList.push_back(Item(i, sequence, width, depth, height, weight, loadCap, 0, 0, itemShapeToggle == 1 ? supportTypes[generator() % 5] : "FULL"));
+	}
+	remainingItemList = uniqueItemList;
+	coveredList.assign(nbItems, 0);
+}
+
+/**
+Fill a bin by placing the first 40 items of the synthetic order as leftovers
+@param the bin object to be filled
+*/
+void fillBenchmarkBin(Bin &bin)
+{
+	vector<Item> leftovers(uniqueItemList.begin(), uniqueItemList.begin() + 40);
+	placeLeftovers(bin, leftovers);
+	bin.setEPSpaces();
+}
+
+/**
+Read benchmark results written by writeBenchmarkResults
+@param the file name and the list the results are added to
+@return true if the file could be read
+*/
+bool readBenchmarkResults(const string &fileName, vector<BenchmarkResult> &results)
+{
+	ifstream file(fileName);
+	if (!file.is_open())
+		return false;
+
+	string line;
+	vector<string> fields;
+	while (getline(file, line))
+	{
+		split(fields, line, "\t");
+		if (fields.size() < 4 || fields[0] == "Kernel")
+			continue;
+
+		BenchmarkResult result;
+		result.name = fields[0];
+		result.nsPerOp = atof(fields[1].c_str());
+		result.allocsPerOp = atof(fields[2].c_str());
+		result.opsPerSecond = atof(fields[3].c_str());
+		results.push_back(result);
+	}
+	return true;
+}
+
+/**
+Write benchmark results as tab separated lines
+@param the file name and the results
+*/
+void writeBenchmarkResults(const string &fileName, const vector<BenchmarkResult> &results)
+{
+	ofstream file(fileName);
+	file << "Kernel\tNsPerOp\tAllocsPerOp\tOpsPerSecond" << endl;
+	for (int i = 0; i < results.size(); i++)
+		file << results[i].name << "\t" << results[i].nsPerOp << "\t" << results[i].allocsPerOp << "\t" << results[i].opsPerSecond << endl;
+}
+
+int main(int argc, char **argv)
+{
+	string outputFile = "MicroBenchmarks.txt";
+	string baselineFile;
+	double minSeconds = 1.0;
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "--quick")
+			minSeconds = 0.05;
+		else if (arg == "--output" && i + 1 < argc)
+			outputFile = argv[++i];
+		else if (arg == "--baseline" && i + 1 < argc)
+			baselineFile = argv[++i];
+	}
+
+	//A regression check without its baseline must not pass
+	vector<BenchmarkResult> baseline;
+	bool hasBaseline = !baselineFile.empty();
+	if (hasBaseline && !readBenchmarkResults(baselineFile, baseline))
+	{
+		cout << "Could not read the baseline " << baselineFile << endl;
+		return 1;
+	}
+
+	//Same settings as the solver
+	maxBinWeight = binWeightToggle == 1 ? 1500000 : 100000000;
+	itemSupportPercentage = verticalSupportToggle == 1 ? 60.0 : 0;
+
+	generateBenchmarkOrder(benchmarkOrderSize, benchmarkSeed);
+	mt19937 generator(benchmarkSeed);
+	vector<BenchmarkResult> results;
+
+	//calculateOverlap on random rectangle pairs, with the support shapes built when the items are created
+	{
+		vector<int> rects(1024 * 8);
+		for (int i = 0; i < rects.size(); i++)
+			rects[i] = (i % 4 < 2) ? generator() % 600 : 50 + generator() % 400;
+		vector<SupportShape> shapes(1024);
+		for (int i = 0; i < shapes.size(); i++)
+			shapes[i] = makeSupportShape(rects[i * 8 + 2], rects[i * 8 + 3], i % 5, 20, 20);
+
+		results.push_back(runBenchmark("calculateOverlap", minSeconds, [&](long long op)
+		{
+			const int *r = &rects[(op % 1024) * 8];
+			benchmarkSink = benchmarkSink + calculateOverlap(shapes[op % 1024], r[0], r[1], r[4], r[5], r[6], r[7]);
+		}));
+
+		//supportOverlaps of a footprint against 16 bottom items
+		SupportBatch batch;
+		for (int i = 0; i < 16; i++)
+			batch.add(shapes[i], rects[i * 8], rects[i * 8 + 1]);
+
+		results.push_back(runBenchmark("supportOverlaps", minSeconds, [&](long long op)
+		{
+			const int *r = &rects[(op % 1024) * 8];
+			supportOverlaps(batch, r[4], r[5], r[6], r[7]);
+			benchmarkSink = benchmarkSink + batch.overlaps[op % 16];
+		}));
+	}
+
+	//MaxRectsBinPack::Insert, filling 610x820 layers with the footprints of a 200 item batch
+	{
+		rbp::MaxRectsBinPack packer;
+		packer.Init(BinWidth, BinDepth);
+		int nextItem = 0;
+
+		results.push_back(runBenchmark("MaxRectsBinPack::Insert", minSeconds, [&](long long op)
+		{
+			const Item &curItem = uniqueItemList[nextItem];
+			nextItem = (nextItem + 1) % BatchSize;
+			rbp::Rect packedRect = packer.Insert(curItem.w, curItem.d, rbp::MaxRectsBinPack::RectBestShortSideFit);
+			if (packedRect.height == 0)
+				packer.Init(BinWidth, BinDepth);
+			benchmarkSink = benchmarkSink + packedRect.x;
+		}));
+	}
+
+	//Bin::checkFeasibility at the extreme points of a bin with stacked items
+	{
+		Bin bin;
+		fillBenchmarkBin(bin);
+		vector<int> placedIDs = bin.itemList;
+
+		results.push_back(runBenchmark("Bin::checkFeasibility", minSeconds, [&](long long op)
+		{
+			const extremePoint &curEP = bin.epList[op % bin.epList.size()];
+			const Item &curItem = uniqueItemList[100 + op % 100];
+			benchmarkSink = benchmarkSink + bin.checkFeasibility(curEP, curItem, curItem.w, curItem.d, curItem.h, op % 4);
+		}));
+
+		//Bin::testCollisions on the 8 orientation and corner combinations of an item at an extreme point
+		results.push_back(runBenchmark("Bin::testCollisions", minSeconds, [&](long long op)
+		{
+			const extremePoint &curEP = bin.epList[op % bin.epList.size()];
+			const Item &curItem = uniqueItemList[100 + op % 100];
+			int boxX[8], boxY[8], boxZ[8], boxW[8], boxD[8], boxH[8];
+			char collides[8];
+			for (int box = 0; box < 8; box++)
+			{
+				boxW[box] = box < 4 ? curItem.w : curItem.d;
+				boxD[box] = box < 4 ? curItem.d : curItem.w;
+				boxH[box] = curItem.h;
+				boxZ[box] = curEP.z;
+				cornerOrigin(curEP, boxW[box], boxD[box], box % 4, boxX[box], boxY[box]);
+			}
+			bin.testCollisions(8, boxX, boxY, boxZ, boxW, boxD, boxH, collides);
+			benchmarkSink = benchmarkSink + collides[op % 8];
+		}));
+		cpyUnique.clear();
+	}
+
+	//Bin::insertItemAtEP, filling bins with rows of items
+	{
+		Bin bin;
+		bin.initiateEPList();
+		int x = 0, y = 0, z = 0, rowDepth = 0;
+
+		results.push_back(runBenchmark("Bin::insertItemAtEP", minSeconds, [&](long long op)
+		{
+			const Item &curItem = uniqueItemList[op % BatchSize];
+			if (x + curItem.w > BinWidth)
+			{
+				x = 0;
+				y += rowDepth;
+				rowDepth = 0;
+			}
+			if (y + curItem.d > BinDepth)
+			{
+				y = 0;
+				z += 500;
+			}
+			if (z + curItem.h > BinHeight)
+			{
+				bin = Bin();
+				bin.initiateEPList();
+				x = 0; y = 0; z = 0; rowDepth = 0;
+			}
+			bin.insertItemAtEP(curItem.w, curItem.d, curItem.h, x, y, z, curItem.ID);
+			x += curItem.w;
+			rowDepth = max(rowDepth, curItem.d);
+			benchmarkSink = benchmarkSink + bin.epList.size();
+		}));
+	}
+
+	//generateSuperItems for a 200 item batch of the order, the batch is taken from the order before the measurement
+	{
+		remainingItemList = uniqueItemList;
+		itemList.clear();
+		generateSuperItems();
+		//The batch is taken from the back of the remaining items, so it is stored reversed to be taken in the same order again
+		vector<Item> batch(itemList.rbegin(), itemList.rend());
+
+		results.push_back(runBenchmark("generateSuperItems", minSeconds, [&](long long op)
+		{
+			remainingItemList = batch;
+			itemList.clear();
+			superItems.clear();
+			itemGroups.clear();
+		},
+		[&](long long op)
+		{
+			generateSuperItems();
+			benchmarkSink = benchmarkSink + superItems.size();
+		}));
+	}
+
+	//Layer::unpack on the initial layers of a batch, including the copy of the layer
+	{
+		remainingItemList = uniqueItemList;
+		itemList.clear();
+		superItems.clear();
+		itemGroups.clear();
+		generateSuperItems();
+		generateInitialLayers();
+		vector<Layer> layers = layerList;
+
+		results.push_back(runBenchmark("Layer::unpack", minSeconds, [&](long long op)
+		{
+			Layer curLayer = layers[op % layers.size()];
+			curLayer.unpack();
+			benchmarkSink = benchmarkSink + curLayer.nbItems();
+		}));
+	}
+
+	//Report the results and compare them with the baseline
+	int nbRegressions = 0;
+
+	for (int i = 0; i < results.size(); i++)
+	{
+		cout << results[i].name << "\t" << results[i].nsPerOp << " ns/op\t" << results[i].allocsPerOp << " allocs/op\t" << results[i].opsPerSecond << " ops/s";
+		for (int j = 0; j < baseline.size() && hasBaseline; j++)
+		{
+			if (baseline[j].name != results[i].name)
+				continue;
+
+			double change = results[i].nsPerOp / baseline[j].nsPerOp - 1;
+			cout << "\t" << (change >= 0 ? "+" : "") << change * 100 << "% vs baseline";
+			if (change > benchmarkTolerance)
+			{
+				cout << "\tREGRESSION";
+				nbRegressions++;
+			}
+		}
+		cout << endl;
+	}
+
+	writeBenchmarkResults(outputFile, results);
+
+	return nbRegressions > 0 ? 1 : 0;
+}
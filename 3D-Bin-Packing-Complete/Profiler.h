@@ -0,0 +1,176 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <mutex>
+#include <cstring>
+#include <type_traits>
+
+/**
+@return the seconds elapsed on a monotonic wall clock since an arbitrary starting point
+*/
+inline double wallClock()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Node of the phase tree of a thread, phases started inside another phase are its children
+struct ProfileNode
+{
+	const char *name;						//Phase name
+	ProfileNode *parent;					//Enclosing phase, NULL for the root
+	std::vector<ProfileNode*> children;		//Phases started inside this phase
+	long long calls;						//Number of times the phase was run
+	double seconds;							//Total wall clock time spent in the phase
+
+	ProfileNode(const char *name, ProfileNode *parent)
+	{
+		this->name = name;
+		this->parent = parent;
+		this->calls = 0;
+		this->seconds = 0;
+	}
+
+	/**
+	Find a child phase, adding it if it is not there yet
+	@param the name of the phase
+	@return the child node
+	*/
+	ProfileNode *child(const char *childName)
+	{
+		//A phase is normally timed at one call site, so its name is found by pointer without comparing the strings
+		for (int i = 0; i < this->children.size(); i++)
+		{
+			if (this->children[i]->name == childName)
+				return this->children[i];
+		}
+		for (int i = 0; i < this->children.size(); i++)
+		{
+			if (strcmp(this->children[i]->name, childName) == 0)
+				return this->children[i];
+		}
+		this->children.push_back(new ProfileNode(childName, this));
+		return this->children.back();
+	}
+};
+
+//Phase trees of all threads that have run a timed phase, nodes are never freed so that the trees stay valid for reporting
+std::vector<ProfileNode*> profileRoots;
+std::mutex profileMutex;
+
+//Phase tree of the calling thread and the phase it is in
+thread_local ProfileNode *profileRoot = NULL;
+thread_local ProfileNode *profileCurrent = NULL;
+
+//Timer that adds the wall clock time of its scope to a phase of the calling thread, placed with PROFILE_SCOPE
+//Phases are nested by scope, so a phase timed inside another one is reported under it
+class ScopedTimer
+{
+public:
+	//Constructor, starts the phase
+	ScopedTimer(const char *name)
+	{
+		if (profileRoot == NULL)
+		{
+			profileRoot = new ProfileNode("", NULL);
+			profileCurrent = profileRoot;
+			std::lock_guard<std::mutex> lock(profileMutex);
+			profileRoots.push_back(profileRoot);
+		}
+
+		profileCurrent = profileCurrent->child(name);
+		this->start = wallClock();
+	}
+
+	//Destructor, ends the phase
+	~ScopedTimer()
+	{
+		profileCurrent->seconds += wallClock() - this->start;
+		profileCurrent->calls++;
+		profileCurrent = profileCurrent->parent;
+	}
+
+private:
+	double start;		//Wall clock time at the start of the phase
+};
+
+//Timer that does nothing, it replaces ScopedTimer when profiling is off
+struct NoTimer
+{
+	NoTimer(const char *name) {}
+};
+
+//Time the enclosing scope as a phase of the calling thread, the timer compiles away when profileToggle is 0
+#define PROFILE_SCOPE(name) std::conditional<profileToggle == 1, ScopedTimer, NoTimer>::type profileTimer(name)
+
+/**
+Reset the counters of a phase tree
+@param the root of the tree
+*/
+void resetProfileNode(ProfileNode *node)
+{
+	node->calls = 0;
+	node->seconds = 0;
+	for (int i = 0; i < node->children.size(); i++)
+		resetProfileNode(node->children[i]);
+}
+
+/**
+Reset the counters of all threads, must not be called while timed phases run on other threads
+*/
+void resetProfile()
+{
+	std::lock_guard<std::mutex> lock(profileMutex);
+	for (int t = 0; t < profileRoots.size(); t++)
+		resetProfileNode(profileRoots[t]);
+}
+
+/**
+Call a function for every phase of a tree that was run
+@param thread number, the node, the path of its parent phase, and the function, called with the thread number, phase path, calls and seconds of the phase
+*/
+template <typename Visitor>
+void visitProfileNode(int thread, ProfileNode *node, const std::string &parentPath, Visitor &visitor)
+{
+	for (int i = 0; i < node->children.size(); i++)
+	{
+		ProfileNode *childNode = node->children[i];
+		std::string path = parentPath.empty() ? childNode->name : parentPath + "/" + childNode->name;
+		if (childNode->calls > 0)
+			visitor(thread, path, childNode->calls, childNode->seconds);
+		visitProfileNode(thread, childNode, path, visitor);
+	}
+}
+
+/**
+Call a function for every phase of all threads that was run, parent phases are separated by / in the phase path
+Thread 0 is the first thread that ran a timed phase, normally the main thread
+@param the function, called with the thread number, phase path, calls and seconds of the phase
+*/
+template <typename Visitor>
+void visitProfile(Visitor visitor)
+{
+	std::lock_guard<std::mutex> lock(profileMutex);
+	for (int t = 0; t < profileRoots.size(); t++)
+		visitProfileNode(t, profileRoots[t], "", visitor);
+}
+
+/**
+Write the per phase breakdown of all threads as tab separated lines: thread number, phase path, calls, seconds
+@param the file name
+*/
+void writeProfile(const std::string &fileName)
+{
+	std::ofstream file(fileName);
+	file << "Thread\tPhase\tCalls\tSeconds" << std::endl;
+
+	visitProfile([&](int thread, const std::string &path, long long calls, double seconds)
+	{
+		file << thread << "\t" << path << "\t" << calls << "\t" << seconds << std::endl;
+	});
+}
+
+#endif
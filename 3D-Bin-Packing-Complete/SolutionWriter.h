@@ -0,0 +1,406 @@
+#ifndef SOLUTIONWRITER_H
+#define SOLUTIONWRITER_H
+
+#include "Common.h"
+#include "Bin.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+//Buffered writer of the solution of an instance into a single file, as JSON lines or as compact binary records
+//
+//JSON lines: one object per line, with the record type in "type"
+//	{"type":"instance","name":...,"items":...}
+//	{"type":"carrier","carrier":...,"bins":...,"items":...,"weight":...,"height":...,"volume":...,"placements":[[id,x,y,z,w,d,h],...]}
+//	{"type":"summary","bins":...,"carriers":...,"layers":...,"leftovers":...,"unplaced":...,"seconds":...}
+//	{"type":"infeasibility","areaSupport":...,"cornerSupport":...,"loadBearing":...,"binWeight":...}
+//	{"type":"timing","thread":...,"phase":...,"calls":...,"seconds":...}
+//
+//Binary: the magic "BP3D" and an int32 version, followed by the same records, each starting with a one byte tag
+//	'I': string name, int32 items
+//	'C': int32 carrier, int32 bins, int32 items, int32 weight, int32 height, int64 volume, then items x int32 [id, x, y, z, w, d, h]
+//	'S': int32 bins, int32 carriers, int32 layers, int32 leftovers, int32 unplaced, float64 seconds
+//	'F': int32 area support, int32 corner support, int32 load bearing, int32 bin weight
+//	'T': int32 thread, string phase, int64 calls, float64 seconds
+//	'E': end of file
+//Integers and doubles are little endian, strings are an int32 length followed by the bytes
+//A carrier holds binsPerCarrier consecutive bins side by side, the x coordinates of its n-th bin are shifted by n times the bin width
+class SolutionWriter
+{
+public:
+	//Constructor
+	SolutionWriter()
+	{
+		this->file = NULL;
+		this->ownsFile = false;
+		this->binary = false;
+	}
+
+	//Destructor
+	~SolutionWriter()
+	{
+		this->close();
+	}
+
+	/**
+	Open the output file
+	@param the file name, and whether the binary format is written instead of JSON lines
+	@return false if the file could not be opened
+	*/
+	bool open(const string &fileName, bool binary)
+	{
+		this->close();
+		if (!this->attach(fopen(fileName.c_str(), "wb"), binary))
+			return false;
+		this->ownsFile = true;
+		return true;
+	}
+
+	/**
+	Write to a stream that is already open, such as a socket, close leaves the stream open
+	@param the stream, and whether the binary format is written instead of JSON lines
+	@return false if the stream is NULL
+	*/
+	bool attach(FILE *stream, bool binary)
+	{
+		this->close();
+		this->file = stream;
+		this->ownsFile = false;
+		this->binary = binary;
+		this->buffer.clear();
+		this->buffer.reserve(solutionBufferSize);
+		if (this->file == NULL)
+			return false;
+
+		if (this->binary)
+		{
+			this->buffer.append("BP3D", 4);
+			this->putInt32(solutionFormatVersion);
+		}
+		return true;
+	}
+
+	/**
+	Write the instance record
+	@param the instance name and its number of items
+	*/
+	void writeInstance(const string &name, int nbItems)
+	{
+		if (this->binary)
+		{
+			this->buffer += 'I';
+			this->putString(name);
+			this->putInt32(nbItems);
+		}
+		else
+		{
+			this->buffer += "{\"type\":\"instance\",\"name\":";
+			this->putJsonString(name);
+			this->buffer += ",\"items\":";
+			this->putText(nbItems);
+			this->buffer += "}\n";
+		}
+		this->flushIfFull();
+	}
+
+	/**
+	Write a carrier record with the placements of the items of its bins, shifting each bin by its position on the carrier
+	@param the carrier index, the bin list and the index of the first bin of the carrier and its number of bins, and the item list that has the weights of the items
+	*/
+	void writeCarrier(int index, const vector<Bin> &bins, int firstBin, int nbBins, const vector<Item> &items)
+	{
+		int nbItems = 0;
+		int height = 0;
+		long long volume = 0;
+		int weight = 0;
+		for (int b = firstBin; b < firstBin + nbBins; b++)
+		{
+			const Bin &bin = bins[b];
+			nbItems += bin.itemWidths.size();
+			for (int i = 0; i < bin.itemWidths.size(); i++)
+			{
+				height = max(height, bin.itemZCoords[i] + bin.itemHeights[i]);
+				volume += (long long)bin.itemWidths[i] * bin.itemDepths[i] * bin.itemHeights[i];
+				if (i < bin.itemList.size())
+					weight += items[bin.itemList[i]].weight;
+			}
+		}
+
+		if (this->binary)
+		{
+			this->buffer += 'C';
+			this->putInt32(index);
+			this->putInt32(nbBins);
+			this->putInt32(nbItems);
+			this->putInt32(weight);
+			this->putInt32(height);
+			this->putInt64(volume);
+		}
+		else
+		{
+			this->buffer += "{\"type\":\"carrier\",\"carrier\":";
+			this->putText(index);
+			this->buffer += ",\"bins\":";
+			this->putText(nbBins);
+			this->buffer += ",\"items\":";
+			this->putText(nbItems);
+			this->buffer += ",\"weight\":";
+			this->putText(weight);
+			this->buffer += ",\"height\":";
+			this->putText(height);
+			this->buffer += ",\"volume\":";
+			this->putText(volume);
+			this->buffer += ",\"placements\":[";
+		}
+
+		bool first = true;
+		for (int b = firstBin; b < firstBin + nbBins; b++)
+		{
+			const Bin &bin = bins[b];
+			int xOffset = (b - firstBin) * BinWidth;
+			for (int i = 0; i < bin.itemWidths.size(); i++)
+			{
+				int placement[7] = { i < bin.itemList.size() ? bin.itemList[i] : -1, bin.itemXCoords[i] + xOffset, bin.itemYCoords[i], bin.itemZCoords[i],
+					bin.itemWidths[i], bin.itemDepths[i], bin.itemHeights[i] };
+				if (this->binary)
+				{
+					for (int k = 0; k < 7; k++)
+						this->putInt32(placement[k]);
+				}
+				else
+				{
+					this->buffer += first ? "[" : ",[";
+					for (int k = 0; k < 7; k++)
+					{
+						if (k > 0)
+							this->buffer += ',';
+						this->putText(placement[k]);
+					}
+					this->buffer += ']';
+				}
+				first = false;
+				this->flushIfFull();
+			}
+		}
+
+		if (!this->binary)
+			this->buffer += "]}\n";
+		this->flushIfFull();
+	}
+
+	/**
+	Write the summary record of the solution
+	@param the number of bins, carriers, layers, leftover items and items that could not be placed, and the solution time
+	*/
+	void writeSummary(int nbBins, int nbCarriers, int nbLayers, int nbLeftoverItems, int nbUnplacedItems, double seconds)
+	{
+		if (this->binary)
+		{
+			this->buffer += 'S';
+			this->putInt32(nbBins);
+			this->putInt32(nbCarriers);
+			this->putInt32(nbLayers);
+			this->putInt32(nbLeftoverItems);
+			this->putInt32(nbUnplacedItems);
+			this->putDouble(seconds);
+		}
+		else
+		{
+			this->buffer += "{\"type\":\"summary\",\"bins\":";
+			this->putText(nbBins);
+			this->buffer += ",\"carriers\":";
+			this->putText(nbCarriers);
+			this->buffer += ",\"layers\":";
+			this->putText(nbLayers);
+			this->buffer += ",\"leftovers\":";
+			this->putText(nbLeftoverItems);
+			this->buffer += ",\"unplaced\":";
+			this->putText(nbUnplacedItems);
+			this->buffer += ",\"seconds\":";
+			this->putText(seconds);
+			this->buffer += "}\n";
+		}
+		this->flushIfFull();
+	}
+
+	/**
+	Write the infeasibility counters of the placement checks
+	*/
+	void writeInfeasibility()
+	{
+		if (this->binary)
+		{
+			this->buffer += 'F';
+			this->putInt32(infAreaSupport);
+			this->putInt32(inf4CSupport);
+			this->putInt32(infLoadBearing);
+			this->putInt32(infBinWeight);
+		}
+		else
+		{
+			this->buffer += "{\"type\":\"infeasibility\",\"areaSupport\":";
+			this->putText(infAreaSupport);
+			this->buffer += ",\"cornerSupport\":";
+			this->putText(inf4CSupport);
+			this->buffer += ",\"loadBearing\":";
+			this->putText(infLoadBearing);
+			this->buffer += ",\"binWeight\":";
+			this->putText(infBinWeight);
+			this->buffer += "}\n";
+		}
+		this->flushIfFull();
+	}
+
+	/**
+	Write the per phase time breakdown of all threads
+	*/
+	void writeTimings()
+	{
+		visitProfile([&](int thread, const std::string &path, long long calls, double seconds)
+		{
+			if (this->binary)
+			{
+				this->buffer += 'T';
+				this->putInt32(thread);
+				this->putString(path);
+				this->putInt64(calls);
+				this->putDouble(seconds);
+			}
+			else
+			{
+				this->buffer += "{\"type\":\"timing\",\"thread\":";
+				this->putText(thread);
+				this->buffer += ",\"phase\":";
+				this->putJsonString(path);
+				this->buffer += ",\"calls\":";
+				this->putText(calls);
+				this->buffer += ",\"seconds\":";
+				this->putText(seconds);
+				this->buffer += "}\n";
+			}
+			this->flushIfFull();
+		});
+	}
+
+	//Write the buffer to the file
+	void flush()
+	{
+		if (this->file != NULL && this->buffer.size() > 0)
+		{
+			fwrite(this->buffer.data(), 1, this->buffer.size(), this->file);
+			fflush(this->file);
+		}
+		this->buffer.clear();
+	}
+
+	//Write the end of the file and close it
+	void close()
+	{
+		if (this->file == NULL)
+			return;
+
+		if (this->binary)
+			this->buffer += 'E';
+		this->flush();
+		if (this->ownsFile)
+			fclose(this->file);
+		this->file = NULL;
+	}
+
+private:
+	FILE *file;			//Output file, NULL if not open
+	bool ownsFile;		//True if the file was opened by the writer and is closed with it
+	bool binary;		//True for the binary format, false for JSON lines
+	string buffer;		//Output not written to the file yet
+
+	//Write the buffer to the file once it is full
+	void flushIfFull()
+	{
+		if (this->buffer.size() >= solutionBufferSize)
+			this->flush();
+	}
+
+	//Append an integer in little endian byte order
+	void putInt32(int32_t value)
+	{
+		uint32_t bits = (uint32_t)value;
+		for (int b = 0; b < 4; b++)
+			this->buffer += (char)((bits >> (8 * b)) & 0xFF);
+	}
+
+	void putInt64(int64_t value)
+	{
+		uint64_t bits = (uint64_t)value;
+		for (int b = 0; b < 8; b++)
+			this->buffer += (char)((bits >> (8 * b)) & 0xFF);
+	}
+
+	void putDouble(double value)
+	{
+		int64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		this->putInt64(bits);
+	}
+
+	void putString(const string &value)
+	{
+		this->putInt32(value.size());
+		this->buffer += value;
+	}
+
+	//Append a number as text, without going through a stream
+	void putText(long long value)
+	{
+		char digits[24];
+		int length = 0;
+		unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : value;
+		do
+		{
+			digits[length++] = '0' + magnitude % 10;
+			magnitude /= 10;
+		} while (magnitude > 0);
+
+		if (value < 0)
+			this->buffer += '-';
+		while (length > 0)
+			this->buffer += digits[--length];
+	}
+
+	void putText(int value)
+	{
+		this->putText((long long)value);
+	}
+
+	void putText(double value)
+	{
+		char text[32];
+		int length = snprintf(text, sizeof(text), "%.9g", value);
+		this->buffer.append(text, length);
+	}
+
+	//Append a quoted JSON string
+	void putJsonString(const string &value)
+	{
+		this->buffer += '"';
+		for (int i = 0; i < value.size(); i++)
+		{
+			char c = value[i];
+			if (c == '"' || c == '\\')
+			{
+				this->buffer += '\\';
+				this->buffer += c;
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				this->buffer += escaped;
+			}
+			else
+				this->buffer += c;
+		}
+		this->buffer += '"';
+	}
+};
+
+#endif
@@ -0,0 +1,439 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "Common.h"
+#include "Item.h"
+#include "Layer.h"
+#include "Bin.h"
+#include "SolutionWriter.h"
+#ifndef NO_CPLEX
+#include "CPLEX.h"
+#endif
+
+//Summary of a solved instance
+struct SolveStats
+{
+	int nbItems;			//Number of items in the instance
+	double seconds;			//Wall clock solution time
+	int nbBins;				//Number of bins in the solution
+	int nbCarriers;			//Number of carriers the bins are written on, see binsPerCarrier
+	int nbLayers;			//Number of layers generated for the last batch
+	int nbLeftoverItems;	//Number of items placed as leftovers in the last batch
+	int nbUnplacedItems;	//Number of items that could not be placed in any bin
+};
+
+/**
+Set parameters based on the toggled practical constraints
+*/
+void setUpParameters()
+{
+	if (binWeightToggle == 1)
+		maxBinWeight = 1500000;
+	else
+		maxBinWeight = 100000000;
+
+	if (verticalSupportToggle == 1)
+		itemSupportPercentage = 60.0;
+	else
+		itemSupportPercentage = 0;
+}
+
+/**
+Reset the bounds gathered over the items of an instance and the random number sequence of the layer generation,
+so that a solve does not depend on the instances solved before it by the same process. Called at the start of every solve
+*/
+void resetInstanceState()
+{
+	srand(1);
+	nbLines = 0;
+	shortestHeight = BinHeight;
+	shortestWD = BinDepth;
+	maxSeqNo = 0;
+	maxLoadCap = 0;
+}
+
+/**
+Solve an instance, and write its bins, solution stats and time breakdown to Results/<instance name>/, or the solution to an output stream
+The bins are streamed as soon as they are final (see closeBin): each one is passed to the sink, and a carrier is written once its last bin is final,
+so the first carriers can be loaded while the later batches are solved. With the local search the bins are only final once it is over
+@param the instance name, the stream of its item lines (see parseItems), the stream the solution is written to (JSON lines, or binary with solutionFormat 2) or NULL to write the files of solutionFormat under Results/<instance name>/,
+and the sink that receives the final bins in the order of the solution
+@return the summary of the solution
+*/
+SolveStats solveInstance(const string &filename, istream &items, FILE *output, const BinSink &sink)
+{
+	//Set up the solution wall clock time counter and the profile of the instance
+	double overallStart = wallClock();
+	double duration;
+	resetProfile();
+	resetInstanceState();
+
+	totalVol = 0;
+
+	//Parse the items from the input stream
+	parseItems(items);
+	//Set up the list that tracks items that are covered
+	for (int i = 0; i < uniqueItemList.size(); i++)
+	{
+		coveredList.push_back(0);
+	}
+	int nLayers = 0;
+
+	//Open the solution file, the carriers are written to it as their bins become final
+	//An output stream always gets the records of the solution file, as JSON lines unless the binary format is set
+	int format = output != NULL && solutionFormat == 0 ? 1 : solutionFormat;
+	SolutionWriter writer;
+	if (output != NULL)
+		writer.attach(output, format == 2);
+	else if (format != 0)
+	{
+		string fileName = "Results/" + filename + (format == 1 ? "/Solution.jsonl" : "/Solution.bin");
+		if (!writer.open(fileName, format == 2))
+			cout << "Could not write " << fileName << endl;
+	}
+	if (format != 0)
+		writer.writeInstance(filename, uniqueItemList.size());
+
+	//Write a carrier, and flush it so that the file can be read while the solution goes on
+	auto writeCarrier = [&](int carrier)
+	{
+		PROFILE_SCOPE("writeSolution");
+		if (format == 0)
+			writeCarrierFile(filename, carrier);
+		else
+		{
+			int firstBin = carrier * binsPerCarrier;
+			writer.writeCarrier(carrier, binList, firstBin, min(binsPerCarrier, (int)binList.size() - firstBin), uniqueItemList);
+			writer.flush();
+		}
+	};
+
+	binSink = [&](int index, const Bin &bin)
+	{
+		if (sink)
+			sink(index, bin);
+		if ((index + 1) % binsPerCarrier == 0)
+			writeCarrier(index / binsPerCarrier);
+	};
+
+	//Loop that places all the items
+	int nbUnplacedItems = 0;
+	while (remainingItemList.size() > 0 || itemList.size() > 0)
+	{
+		int nbItemsBefore = remainingItemList.size() + itemList.size();
+		nbLeftoverItems = 0;
+		//Generate super items and group items based on their heights
+		generateSuperItems();
+
+#ifdef NO_CPLEX
+		//Without CPLEX there is no master problem, the bins are built from the initial layers and the leftover placement
+		nItems = itemList.size();
+		generateInitialLayers();
+#else
+		//Set up parameters used during the solution process
+		int iteration = 1;
+		int nbLayers = 0;
+		int improvementCounter = 0;
+		double objectiveValue = pow(10.0, 15);
+		int nUniqueItems = nItems;
+		double improvementObj = pow(10.0, 15);
+		int nbLayersLast = 0;
+		int mispricings = 0;
+		double lowerBound = 0;
+		vector<double> smoothedDuals;
+		stabilityCenter.clear();
+		nItems = itemList.size();
+
+		//Set up CPLEX parameters and variables
+		IloEnv env = masterEnvironment();
+		IloNumVar::Type varType = ILOFLOAT;
+		IloModel mod(env);
+		IloNumVarArray alpha(env);
+		IloNumArray constrMin(env, uniqueItemList.size());
+		IloNumArray constrMax(env, uniqueItemList.size());
+		for (IloInt i = 0; i < uniqueItemList.size(); i++)
+		{
+			constrMin[i] = 1;
+			constrMax[i] = IloInfinity;
+		}
+		IloRangeArray range(env, constrMin, constrMax);
+		IloObjective cost = IloAdd(mod, IloMinimize(env));
+
+		//Start iteration timer
+		double start = wallClock();
+
+		//Layer generation loop
+		while (true)
+		{
+			bool cont = false;
+			bool repriced = false;
+			
+			//Generate layers
+			if (iteration == 1)
+				generateInitialLayers();			//Generate layers using random dual values
+			else
+			{
+				cont = generateLayers("normal");	//Generate layers using calculated dual values
+
+				//The bound only holds for the duals of the master LP, so it is taken from pricing with the exact duals
+				if (dualSmoothingFactor == 0)
+					lowerBound = max(lowerBound, lagrangianBound(rawDuals, objectiveValue));
+
+				//If the smoothed duals price out no new layers, price with the exact duals before stopping
+				if (dualSmoothingFactor > 0 && (cont == false || layerList.size() == nbLayers))
+				{
+					applyDuals(rawDuals);
+					mispricings++;
+					repriced = generateLayers("normal");
+					if (repriced)
+						cont = true;
+					lowerBound = max(lowerBound, lagrangianBound(rawDuals, objectiveValue));
+				}
+			}
+
+			//If the master objective is close enough to its lower bound, break, unless repricing with the exact duals just found layers
+			if (iteration > 1 && cgGapTolerance > 0 && !repriced && (objectiveValue - lowerBound) / objectiveValue <= cgGapTolerance)
+				break;
+
+			//std::cout << "Case\t" << q << "\t||\tIteration " << iteration << endl;
+
+			//If no layers are generated, break
+			if (iteration > 1 && cont == false)
+				break;
+
+			if (iteration > 1 && layerList.size() == nbLayers)
+				break;
+
+			//If there are no significant improvements in the last few iterations, break
+			if (improvementCounter == improvementLimit)
+				break;
+
+			//If the time limit is violated, break
+			if (wallClock() - start > 1200)
+				break;
+			
+			//If there are less than 10 items, don't generate layers
+			if (itemList.size() < 10)
+				break;
+
+			nbLayers = layerList.size();
+
+			if (iteration == 1)
+			{
+				//Set up one item layers to guarantee feasibility of the mathematical model
+				for (int i = 0; i < uniqueItemList.size(); i++)
+				{
+					Layer newLayer;
+					newLayer.insertItem(uniqueItemList[i], 0, 0, 0);
+					newLayer.layerHeight = uniqueItemList[i].h;
+					newLayer.layerOccupancy = (uniqueItemList[i].d * uniqueItemList[i].w * 100.0) / (BinDepth * BinWidth);
+					addLayer(newLayer);
+				}
+			}
+
+			if (iteration == 1)
+			{
+				//Build the model for the first time
+				resetColumnPool();
+				IloInt nColumns = layerList.size();
+				buildModelByColumn(mod, alpha, uniqueItemList.size(), nColumns, layerList, varType, range, cost);
+			}
+			else
+			{
+				//Add new columns
+				for (int k = nbLayersLast; k < layerList.size(); k++)
+				{
+					IloNumColumn col;
+					col = cost(layerList[k].layerHeight);
+
+					for (int i = 0; i < uniqueItemList.size(); i++)
+					{
+						col += range[i](0);
+					}
+
+					alpha.add(IloNumVar(col, 0, 1, varType));
+					col.end();
+
+					for (int i = 0; i < layerList[k].nbItems(); i++)
+					{
+						if (layerList[k].item(i).SIList.size() == 0)
+							range[layerList[k].item(i).ID].setLinearCoef(alpha[k], 1);
+						else
+						{
+							for (int j = 0; j < layerList[k].item(i).SIList.size(); j++)
+							{
+								range[layerList[k].item(i).SIList[j].ID].setLinearCoef(alpha[k], 1);
+							}
+						}
+					}
+				}
+			}
+
+			//Create the mathematical model object
+			IloCplex cplex(mod);
+			//cplex.exportModel("Model.mps");
+			cplex.setOut(env.getNullStream());
+			{
+				PROFILE_SCOPE("masterSolve");
+				cplex.solve();
+			}
+
+			nbLayersLast = layerList.size();
+
+			if (iteration == 1)
+				improvementObj = cplex.getObjValue();
+
+			//Get the objective functuion value and reset the improvement counter if necessary
+			if ((improvementObj - cplex.getObjValue()) / cplex.getObjValue() > 0.001)
+			{
+				improvementCounter = 0;
+				improvementObj = cplex.getObjValue();
+			}
+			else
+				improvementCounter++;
+
+			objectiveValue = cplex.getObjValue();
+
+			//Update the dual values, smoothed towards the stability center
+			double dualStep = 0;
+			{
+				PROFILE_SCOPE("dualPropagation");
+				readDuals(cplex, range, rawDuals);
+				if (dualSmoothingFactor > 0)
+				{
+					dualStep = smoothDuals(rawDuals, smoothedDuals);
+					applyDuals(smoothedDuals);
+				}
+				else
+					applyDuals(rawDuals);
+			}
+
+			if (cgLogToggle == 1)
+				logIteration(iteration, objectiveValue, lowerBound, dualStep, mispricings, wallClock() - start);
+
+			//Age unused columns out of the LP and keep the pool below its memory limit
+			manageColumnPool(cplex, alpha, iteration);
+			nbLayers = layerList.size();
+			nbLayersLast = layerList.size();
+
+			iteration++;
+			cplex.end();
+		}//while(true)
+
+		//Select a disjoint set of layers from the final master LP for bin construction
+		if (divingToggle == 1 && alpha.getSize() > 0)
+			diveLayerSelection(mod, alpha);
+#endif
+
+		//Purged columns are considered by bin construction too
+		restoreColdLayers();
+
+		nLayers = layerList.size();
+		//Construct the bins
+		constructBinsVerticalSupport();
+
+		//Reset lists that will need to be regenerated
+		superItems.clear();
+		itemGroups.clear();
+#ifndef NO_CPLEX
+		//The environment outlives the batch, so the variables, constraints and objective are ended with the model
+		alpha.endElements();
+		alpha.end();
+		constrMin.end();
+		constrMax.end();
+		range.endElements();
+		range.end();
+		cost.end();
+		mod.end();
+#endif
+
+		//Stop if the batch placed no item, the remaining items do not fit in an empty bin and would be batched again forever
+		if (remainingItemList.size() + itemList.size() == nbItemsBefore)
+		{
+			nbUnplacedItems = nbItemsBefore;
+			cout << "No item of the batch could be placed, " << nbUnplacedItems << " items are left unplaced" << endl;
+			remainingItemList.clear();
+			itemList.clear();
+			break;
+		}
+	}//while(remainingItemList.size() > 0)
+
+	//Try to empty the least filled bins, the bins are final after it
+	if (localSearchTimeLimit > 0)
+	{
+		improveBins();
+		for (int b = 0; b < binList.size(); b++)
+			binSink(b, binList[b]);
+	}
+
+	//Write the last carrier if its bins do not fill it
+	if (binList.size() % binsPerCarrier != 0)
+		writeCarrier(binList.size() / binsPerCarrier);
+	binSink = BinSink();
+
+	//Write the total solution time
+	//cout << "Total time elapsed is: " << wallClock() - overallStart << endl;
+	cout << "Finished the case:\t" << filename << endl;
+
+	SolveStats stats;
+	stats.nbItems = uniqueItemList.size();
+	stats.seconds = wallClock() - overallStart;
+	stats.nbBins = binList.size();
+	stats.nbCarriers = nbCarriers(binList.size());
+	stats.nbLayers = nLayers;
+	stats.nbLeftoverItems = nbLeftoverItems;
+	stats.nbUnplacedItems = nbUnplacedItems;
+
+	if (format == 0)
+	{
+		//Write solution stats
+		ofstream solStats;
+		string fileName = "Results/" + filename + "/SolutionStats.txt";
+		solStats.open(fileName);
+
+		solStats << stats.nbItems << "\t" << stats.seconds << "\t" << stats.nbCarriers << "\t" << stats.nbLayers << "\t" << stats.nbLeftoverItems << 
+			"\t" << infAreaSupport << "\t" << inf4CSupport << "\t" << infLoadBearing << "\t" << infBinWeight << endl;
+	
+		//Write the per phase time breakdown
+		if (profileToggle == 1)
+			writeProfile("Results/" + filename + "/Profile.txt");
+	}
+	else
+	{
+		//Close the solution file with the bin stats, infeasibility counters and timings
+		writer.writeSummary(stats.nbBins, stats.nbCarriers, stats.nbLayers, stats.nbLeftoverItems, stats.nbUnplacedItems, stats.seconds);
+		writer.writeInfeasibility();
+		if (profileToggle == 1)
+			writer.writeTimings();
+		writer.close();
+	}
+
+	//Clear everything to ensure no memory leaks
+	uniqueItemList.clear();
+	superItems.clear();
+	layerList.clear();
+	layerSignatureIndex.clear();
+	coldLayerList.clear();
+	selectedLayerList.clear();
+	binList.clear();
+	layerItemPool.clear();
+	layerItemPoolIndex.clear();
+	itemGroups.clear();
+	coveredList.clear();
+	spacingCache.clear();
+
+	return stats;
+}
+
+/**
+Solve an instance read from ../../Parameters/<instance name>.txt, and write its bins, solution stats and time breakdown to Results/<instance name>/
+@param the instance name, the path of its item file under ../../Parameters without the .txt extension, and the sink that receives the final bins in the order of the solution
+@return the summary of the solution
+*/
+SolveStats solveInstance(const string &filename, const BinSink &sink = BinSink())
+{
+	ifstream items("../../Parameters/" + filename + ".txt");
+	return solveInstance(filename, items, NULL, sink);
+}
+
+#endif
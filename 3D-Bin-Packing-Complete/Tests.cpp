@@ -0,0 +1,447 @@
+#include "Common.h"
+#include "Item.h"
+#include "Layer.h"
+#include "Bin.h"
+#include "SolutionWriter.h"
+#include <cstdio>
+#include <sstream>
+
+//Tests of the kernels that replaced simpler code, against that code, and of the layer deduplication and the solution formats
+//Usage: Tests
+//Every failed check is reported, and the exit code is 1 if any check failed
+
+#define testSeed 2024					// Seed of the random test inputs
+
+//Number of failed checks
+int nbFailedChecks = 0;
+
+/**
+Report a failed check
+@param the result of the check and the description of the check
+*/
+void check(bool condition, const string &description)
+{
+	if (condition)
+		return;
+	nbFailedChecks++;
+	cout << "FAILED: " << description << endl;
+}
+
+/**
+Find the first placed box that collides with a box, the six comparisons of the separating axis test one box at a time
+@param the bin with the placed boxes, and x, y, z coordinates and width, depth, height dimensions of the box
+@return the index of the first colliding placed box, -1 if the box does not collide with any
+*/
+int referenceCollision(const Bin &bin, int x, int y, int z, int w, int d, int h)
+{
+	for (int k = 0; k < bin.itemWidths.size(); k++)
+	{
+		if (x + w > bin.itemXCoords[k] && y + d > bin.itemYCoords[k] && z + h > bin.itemZCoords[k] &&
+			bin.itemXCoords[k] + bin.itemWidths[k] > x && bin.itemYCoords[k] + bin.itemDepths[k] > y && bin.itemZCoords[k] + bin.itemHeights[k] > z)
+			return k;
+	}
+	return -1;
+}
+
+/**
+Bin::findCollision, Bin::testCollisions and findCollisionAvx2 against the separating axis test on random boxes
+Coordinates are on a coarse grid, so that many boxes only touch
+*/
+void testCollisions()
+{
+	mt19937 generator(testSeed);
+#if defined(COLLISION_AVX2_DISPATCH)
+	bool testAvx2 = __builtin_cpu_supports("avx2");
+#elif defined(COLLISION_AVX2)
+	bool testAvx2 = true;
+#endif
+
+	for (int trial = 0; trial < 2000; trial++)
+	{
+		Bin bin;
+		int nbPlaced = generator() % 41;
+		for (int k = 0; k < nbPlaced; k++)
+		{
+			bin.itemXCoords.push_back((generator() % 12) * 50);
+			bin.itemYCoords.push_back((generator() % 16) * 50);
+			bin.itemZCoords.push_back((generator() % 40) * 50);
+			bin.itemWidths.push_back((1 + generator() % 6) * 50);
+			bin.itemDepths.push_back((1 + generator() % 6) * 50);
+			bin.itemHeights.push_back((1 + generator() % 6) * 50);
+		}
+
+		int xs[8], ys[8], zs[8], ws[8], ds[8], hs[8];
+		char collides[8];
+		for (int box = 0; box < 8; box++)
+		{
+			xs[box] = (generator() % 12) * 50;
+			ys[box] = (generator() % 16) * 50;
+			zs[box] = (generator() % 40) * 50;
+			ws[box] = (1 + generator() % 6) * 50;
+			ds[box] = (1 + generator() % 6) * 50;
+			hs[box] = (1 + generator() % 6) * 50;
+		}
+		bin.testCollisions(8, xs, ys, zs, ws, ds, hs, collides);
+
+		for (int box = 0; box < 8; box++)
+		{
+			int expected = referenceCollision(bin, xs[box], ys[box], zs[box], ws[box], ds[box], hs[box]);
+			string description = "collision of box " + to_string(box) + " in trial " + to_string(trial);
+			check(bin.findCollision(xs[box], ys[box], zs[box], ws[box], ds[box], hs[box]) == expected, "Bin::findCollision, " + description);
+			check(collides[box] == (expected >= 0 ? 1 : 0), "Bin::testCollisions, " + description);
+#ifdef COLLISION_AVX2
+			if (testAvx2)
+			{
+				int found = findCollisionAvx2(nbPlaced, xs[box], ys[box], zs[box], ws[box], ds[box], hs[box], bin.itemXCoords.data(), bin.itemYCoords.data(),
+					bin.itemZCoords.data(), bin.itemWidths.data(), bin.itemDepths.data(), bin.itemHeights.data());
+				check(found == expected, "findCollisionAvx2, " + description);
+			}
+#endif
+		}
+	}
+}
+
+/**
+The support shape overlap and supportOverlaps against the legacy calculateOverlap, for all support types with and without edge reduce
+Top items are placed around the bottom items on a 9 mm grid, so that they overlap, touch and miss the edge supports and the corners
+*/
+void testSupportOverlaps()
+{
+	mt19937 generator(testSeed);
+	const int edgeReduces[3] = { 0, 10, 25 };
+
+	for (int supportType = 0; supportType < 5; supportType++)
+	{
+		for (int trial = 0; trial < 300; trial++)
+		{
+			//A batch of bottom items of the support type next to each other
+			int edgeReduceW = edgeReduces[generator() % 3];
+			int edgeReduceD = edgeReduces[generator() % 3];
+			SupportBatch batch;
+			vector<int> x1(6), y1(6), w1(6), d1(6);
+			for (int i = 0; i < 6; i++)
+			{
+				w1[i] = 120 + generator() % 300;
+				d1[i] = 120 + generator() % 300;
+				x1[i] = (i % 3) * 400;
+				y1[i] = (i / 3) * 400;
+				batch.add(makeSupportShape(w1[i], d1[i], supportType, edgeReduceW, edgeReduceD), x1[i], y1[i]);
+			}
+
+			for (int top = 0; top < 20; top++)
+			{
+				int x2 = (generator() % 140) * 9 - 60;
+				int y2 = (generator() % 100) * 9 - 60;
+				int w2 = 30 + generator() % 400;
+				int d2 = 30 + generator() % 400;
+				supportOverlaps(batch, x2, y2, w2, d2);
+
+				for (int i = 0; i < 6; i++)
+				{
+					double expected = calculateOverlap(x1[i], y1[i], w1[i], d1[i], x2, y2, w2, d2, supportType, edgeReduceW, edgeReduceD);
+					SupportShape shape = makeSupportShape(w1[i], d1[i], supportType, edgeReduceW, edgeReduceD);
+					string description = "support type " + to_string(supportType) + ", edge reduce " + to_string(edgeReduceW) + "x" + to_string(edgeReduceD) +
+						", bottom " + to_string(w1[i]) + "x" + to_string(d1[i]) + " at " + to_string(x1[i]) + "," + to_string(y1[i]) +
+						", top " + to_string(w2) + "x" + to_string(d2) + " at " + to_string(x2) + "," + to_string(y2) + ": expected " + to_string(expected);
+					check(calculateOverlap(shape, x1[i], y1[i], x2, y2, w2, d2) == expected, "calculateOverlap with a support shape, " + description);
+					check(batch.overlaps[i] == expected, "supportOverlaps, " + description);
+				}
+			}
+		}
+	}
+}
+
+/**
+addLayer rejects layers with the same items at the same positions in any order, removeDuplicateLayers drops them and rebuilds the signature index,
+and rebuildLayerSignatureIndex keeps every layer at its position
+*/
+void testLayerDeduplication()
+{
+	uniqueItemList.clear();
+	for (int i = 0; i < 3; i++)
+		uniqueItemList.push_back(Item(i, 1, 200 + 10 * i, 300, 150, 1000, 5000, 0, 0, "FULL"));
+
+	Layer layer1, sameItemsReversed, movedItem;
+	layer1.insertItem(uniqueItemList[0], 0, 0, 0);
+	layer1.insertItem(uniqueItemList[1], 1, 250, 0);
+	sameItemsReversed.insertItem(uniqueItemList[1], 1, 250, 0);
+	sameItemsReversed.insertItem(uniqueItemList[0], 0, 0, 0);
+	movedItem.insertItem(uniqueItemList[0], 0, 0, 0);
+	movedItem.insertItem(uniqueItemList[1], 1, 260, 0);
+
+	layerList.clear();
+	layerSignatureIndex.clear();
+	check(addLayer(layer1), "addLayer adds a new layer");
+	check(!addLayer(sameItemsReversed), "addLayer rejects the same items in another order");
+	check(addLayer(movedItem), "addLayer adds a layer with an item at another position");
+	check(layerList.size() == 2, "addLayer keeps 2 layers");
+
+	//Duplicates that bypass addLayer, the signature index must not drop or move them
+	layerList.push_back(sameItemsReversed);
+	layerList.push_back(movedItem);
+	vector<vector<unsigned long long>> itemsBefore;
+	for (int k = 0; k < layerList.size(); k++)
+		itemsBefore.push_back(layerList[k].canonicalItems());
+	rebuildLayerSignatureIndex();
+	check(layerList.size() == 4, "rebuildLayerSignatureIndex keeps every layer");
+	for (int k = 0; k < layerList.size(); k++)
+		check(layerList[k].canonicalItems() == itemsBefore[k], "rebuildLayerSignatureIndex keeps layer " + to_string(k) + " at its position");
+
+	removeDuplicateLayers();
+	check(layerList.size() == 2, "removeDuplicateLayers keeps 2 layers");
+	check(layerSignatureIndex.size() == layerList.size(), "removeDuplicateLayers indexes every layer");
+	for (int k = 0; k < layerList.size(); k++)
+	{
+		unordered_map<unsigned long long, int>::iterator it = layerSignatureIndex.find(layerList[k].signature);
+		check(it != layerSignatureIndex.end() && it->second == k, "removeDuplicateLayers indexes layer " + to_string(k) + " at its position");
+	}
+	check(!addLayer(sameItemsReversed) && !addLayer(movedItem), "addLayer rejects the layers after removeDuplicateLayers");
+
+	layerList.clear();
+	layerSignatureIndex.clear();
+}
+
+/**
+Read the integers and numbers that follow a key in a JSON line
+@param the line and the key
+@return the value after the key, 0 if the key is not in the line
+*/
+double jsonNumber(const string &line, const string &key)
+{
+	size_t position = line.find("\"" + key + "\":");
+	if (position == string::npos)
+		return 0;
+	return atof(line.c_str() + position + key.size() + 3);
+}
+
+/**
+Read all the integers of the placements array of a JSON carrier line
+@param the line
+@return the integers in the order they are written
+*/
+vector<int> jsonPlacements(const string &line)
+{
+	vector<int> values;
+	size_t position = line.find("\"placements\":");
+	if (position == string::npos)
+		return values;
+
+	const char *text = line.c_str() + position + 13;
+	while (*text != '\0')
+	{
+		if (*text == '-' || (*text >= '0' && *text <= '9'))
+		{
+			char *end;
+			values.push_back(strtol(text, &end, 10));
+			text = end;
+		}
+		else
+			text++;
+	}
+	return values;
+}
+
+//Reader of the binary solution format
+struct BinaryReader
+{
+	string data;		//Contents of the file
+	size_t position;	//Position of the next value
+
+	int readInt32()
+	{
+		uint32_t bits = 0;
+		for (int b = 0; b < 4 && this->position < this->data.size(); b++)
+			bits |= (uint32_t)(unsigned char)this->data[this->position++] << (8 * b);
+		return (int32_t)bits;
+	}
+
+	long long readInt64()
+	{
+		uint64_t bits = 0;
+		for (int b = 0; b < 8 && this->position < this->data.size(); b++)
+			bits |= (uint64_t)(unsigned char)this->data[this->position++] << (8 * b);
+		return (int64_t)bits;
+	}
+
+	double readDouble()
+	{
+		long long bits = this->readInt64();
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	string readString()
+	{
+		int length = this->readInt32();
+		string value = this->data.substr(this->position, length);
+		this->position += length;
+		return value;
+	}
+
+	char readTag()
+	{
+		return this->position < this->data.size() ? this->data[this->position++] : '\0';
+	}
+};
+
+/**
+Read a whole file
+@param the file name
+@return the contents of the file
+*/
+string readFile(const string &fileName)
+{
+	ifstream file(fileName, ios::binary);
+	return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+/**
+Write the records of a small solution with SolutionWriter and read them back, in the JSON lines and the binary format
+*/
+void testSolutionWriter()
+{
+	uniqueItemList.clear();
+	for (int i = 0; i < 5; i++)
+		uniqueItemList.push_back(Item(i, 1, 200, 300, 100 + 50 * i, 1000 + i, 5000, 0, 0, "FULL"));
+
+	//Two bins of one carrier, the items of the second bin are shifted by the bin width on the carrier
+	vector<Bin> bins(2);
+	vector<int> expectedPlacements;
+	for (int i = 0; i < 5; i++)
+	{
+		Bin &bin = bins[i % 2];
+		bin.itemList.push_back(i);
+		bin.itemXCoords.push_back(10 * i);
+		bin.itemYCoords.push_back(20 * i);
+		bin.itemZCoords.push_back(30 * i);
+		bin.itemWidths.push_back(uniqueItemList[i].w);
+		bin.itemDepths.push_back(uniqueItemList[i].d);
+		bin.itemHeights.push_back(uniqueItemList[i].h);
+	}
+	for (int b = 0; b < 2; b++)
+	{
+		for (int i = 0; i < bins[b].itemList.size(); i++)
+		{
+			int placement[7] = { bins[b].itemList[i], bins[b].itemXCoords[i] + b * BinWidth, bins[b].itemYCoords[i], bins[b].itemZCoords[i],
+				bins[b].itemWidths[i], bins[b].itemDepths[i], bins[b].itemHeights[i] };
+			expectedPlacements.insert(expectedPlacements.end(), placement, placement + 7);
+		}
+	}
+	int expectedWeight = 0;
+	int expectedHeight = 0;
+	long long expectedVolume = 0;
+	for (int i = 0; i < 5; i++)
+	{
+		expectedWeight += uniqueItemList[i].weight;
+		expectedHeight = max(expectedHeight, 30 * i + uniqueItemList[i].h);
+		expectedVolume += (long long)uniqueItemList[i].w * uniqueItemList[i].d * uniqueItemList[i].h;
+	}
+
+	infAreaSupport = 11;
+	inf4CSupport = 12;
+	infLoadBearing = 13;
+	infBinWeight = 14;
+	const string name = "order \"7\"\t1";
+
+	for (int binary = 0; binary < 2; binary++)
+	{
+		string fileName = binary == 1 ? "TestsSolution.bin" : "TestsSolution.jsonl";
+		SolutionWriter writer;
+		check(writer.open(fileName, binary == 1), "SolutionWriter opens " + fileName);
+		writer.writeInstance(name, 5);
+		writer.writeCarrier(0, bins, 0, 2, uniqueItemList);
+		writer.writeSummary(2, 1, 7, 3, 1, 1.25);
+		writer.writeInfeasibility();
+		writer.close();
+
+		if (binary == 1)
+		{
+			BinaryReader reader;
+			reader.data = readFile(fileName);
+			reader.position = 4;
+			check(reader.data.compare(0, 4, "BP3D") == 0, "binary solution starts with the magic");
+			check(reader.readInt32() == solutionFormatVersion, "binary solution has the format version");
+
+			check(reader.readTag() == 'I', "binary instance record");
+			check(reader.readString() == name, "binary instance name");
+			check(reader.readInt32() == 5, "binary instance items");
+
+			check(reader.readTag() == 'C', "binary carrier record");
+			check(reader.readInt32() == 0, "binary carrier index");
+			check(reader.readInt32() == 2, "binary carrier bins");
+			int nbItems = reader.readInt32();
+			check(nbItems == 5, "binary carrier items");
+			check(reader.readInt32() == expectedWeight, "binary carrier weight");
+			check(reader.readInt32() == expectedHeight, "binary carrier height");
+			check(reader.readInt64() == expectedVolume, "binary carrier volume");
+			vector<int> placements;
+			for (int k = 0; k < nbItems * 7; k++)
+				placements.push_back(reader.readInt32());
+			check(placements == expectedPlacements, "binary carrier placements");
+
+			check(reader.readTag() == 'S', "binary summary record");
+			int summary[5];
+			for (int k = 0; k < 5; k++)
+				summary[k] = reader.readInt32();
+			check(summary[0] == 2 && summary[1] == 1 && summary[2] == 7 && summary[3] == 3 && summary[4] == 1, "binary summary counts");
+			check(reader.readDouble() == 1.25, "binary summary seconds");
+
+			check(reader.readTag() == 'F', "binary infeasibility record");
+			int counts[4];
+			for (int k = 0; k < 4; k++)
+				counts[k] = reader.readInt32();
+			check(counts[0] == 11 && counts[1] == 12 && counts[2] == 13 && counts[3] == 14, "binary infeasibility counts");
+
+			check(reader.readTag() == 'E' && reader.position == reader.data.size(), "binary solution ends after the end record");
+		}
+		else
+		{
+			vector<string> lines;
+			istringstream input(readFile(fileName));
+			string line;
+			while (getline(input, line))
+				lines.push_back(line);
+
+			check(lines.size() == 4, "JSON solution has 4 lines");
+			if (lines.size() < 4)
+				continue;
+			check(lines[0].find("\"type\":\"instance\"") != string::npos, "JSON instance record");
+			check(lines[0].find("\"name\":\"order \\\"7\\\"\\u00091\"") != string::npos, "JSON instance name is escaped");
+			check(jsonNumber(lines[0], "items") == 5, "JSON instance items");
+
+			check(lines[1].find("\"type\":\"carrier\"") != string::npos, "JSON carrier record");
+			check(jsonNumber(lines[1], "carrier") == 0 && jsonNumber(lines[1], "bins") == 2 && jsonNumber(lines[1], "items") == 5, "JSON carrier counts");
+			check(jsonNumber(lines[1], "weight") == expectedWeight && jsonNumber(lines[1], "height") == expectedHeight && jsonNumber(lines[1], "volume") == expectedVolume, "JSON carrier totals");
+			check(jsonPlacements(lines[1]) == expectedPlacements, "JSON carrier placements");
+
+			check(lines[2].find("\"type\":\"summary\"") != string::npos, "JSON summary record");
+			check(jsonNumber(lines[2], "bins") == 2 && jsonNumber(lines[2], "carriers") == 1 && jsonNumber(lines[2], "layers") == 7 &&
+				jsonNumber(lines[2], "leftovers") == 3 && jsonNumber(lines[2], "unplaced") == 1, "JSON summary counts");
+			check(jsonNumber(lines[2], "seconds") == 1.25, "JSON summary seconds");
+
+			check(lines[3].find("\"type\":\"infeasibility\"") != string::npos, "JSON infeasibility record");
+			check(jsonNumber(lines[3], "areaSupport") == 11 && jsonNumber(lines[3], "cornerSupport") == 12 &&
+				jsonNumber(lines[3], "loadBearing") == 13 && jsonNumber(lines[3], "binWeight") == 14, "JSON infeasibility counts");
+		}
+		remove(fileName.c_str());
+	}
+
+	uniqueItemList.clear();
+}
+
+int main()
+{
+	testCollisions();
+	testSupportOverlaps();
+	testLayerDeduplication();
+	testSolutionWriter();
+
+	if (nbFailedChecks > 0)
+	{
+		cout << nbFailedChecks << " checks failed" << endl;
+		return 1;
+	}
+	cout << "All checks passed" << endl;
+	return 0;
+}
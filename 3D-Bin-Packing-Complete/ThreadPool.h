@@ -0,0 +1,169 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+//Flag that marks threads that are currently running tasks of a parallel loop
+thread_local bool insideParallelRegion = false;
+
+//Class definition for a persistent pool of worker threads
+//The calling thread takes part in every parallel loop, so a pool with n workers runs n + 1 tasks at a time
+class ThreadPool
+{
+public:
+	//Constructor
+	ThreadPool(int nbWorkers)
+	{
+		this->stopFlag = false;
+		this->jobID = 0;
+		this->busyWorkers = 0;
+		this->taskCount = 0;
+		this->currentTask = NULL;
+
+		for (int i = 0; i < nbWorkers; i++)
+			this->workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+
+	//Destructor
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->poolMutex);
+			this->stopFlag = true;
+		}
+		this->jobReady.notify_all();
+
+		for (int i = 0; i < this->workers.size(); i++)
+			this->workers[i].join();
+	}
+
+	/**
+	Run a task for every index in [0, count) and wait until all of them are finished
+	Nested calls, and calls made while another thread is using the pool, run serially on the calling thread
+	If a task throws, the tasks that have not started are skipped, and the first exception is thrown again on the calling thread once all the threads are done
+	@param number of tasks and the task to be run with the task index
+	*/
+	void parallelFor(int count, const std::function<void(int)> &task)
+	{
+		if (count <= 0)
+			return;
+
+		std::unique_lock<std::mutex> jobLock(this->jobMutex, std::try_to_lock);
+		if (this->workers.size() == 0 || count == 1 || insideParallelRegion || !jobLock.owns_lock())
+		{
+			for (int i = 0; i < count; i++)
+				task(i);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(this->poolMutex);
+			this->currentTask = &task;
+			this->taskCount = count;
+			this->nextIndex = 0;
+			this->busyWorkers = this->workers.size();
+			this->jobID++;
+		}
+		this->jobReady.notify_all();
+
+		//The calling thread works on the tasks as well
+		runTasks(task, count);
+
+		std::exception_ptr exception;
+		{
+			std::unique_lock<std::mutex> lock(this->poolMutex);
+			this->jobDone.wait(lock, [this] { return this->busyWorkers == 0; });
+			this->currentTask = NULL;
+			exception = this->taskException;
+			this->taskException = NULL;
+		}
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	/**
+	@return the number of threads that run tasks of a parallel loop at the same time
+	*/
+	int size() const
+	{
+		return this->workers.size() + 1;
+	}
+
+private:
+	std::vector<std::thread> workers;				//Worker threads
+	std::mutex poolMutex;							//Guards the job description below
+	std::mutex jobMutex;							//Held by the thread that owns the current job
+	std::condition_variable jobReady, jobDone;		//Signals for a new job and for a worker finishing the current job
+	const std::function<void(int)> *currentTask;	//Task of the current job
+	int taskCount;									//Number of tasks in the current job
+	std::atomic<int> nextIndex;						//Next task index to be taken
+	int busyWorkers;								//Number of workers that have not finished the current job
+	long long jobID;								//Counter that identifies jobs
+	bool stopFlag;									//Set when the pool is destroyed
+	std::exception_ptr taskException;				//First exception thrown by a task of the current job
+
+	/**
+	Take task indices until the current job runs out of tasks, exceptions are kept for the calling thread of the job
+	@param the task and the number of tasks
+	*/
+	void runTasks(const std::function<void(int)> &task, int count)
+	{
+		insideParallelRegion = true;
+		int index;
+		while ((index = this->nextIndex.fetch_add(1)) < count)
+		{
+			try
+			{
+				task(index);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(this->poolMutex);
+				if (!this->taskException)
+					this->taskException = std::current_exception();
+				this->nextIndex = count;
+			}
+		}
+		insideParallelRegion = false;
+	}
+
+	/**
+	Main loop of a worker thread
+	*/
+	void workerLoop()
+	{
+		long long lastJobID = 0;
+
+		while (true)
+		{
+			const std::function<void(int)> *task;
+			int count;
+			{
+				std::unique_lock<std::mutex> lock(this->poolMutex);
+				this->jobReady.wait(lock, [&] { return this->stopFlag || this->jobID != lastJobID; });
+				if (this->stopFlag)
+					return;
+				lastJobID = this->jobID;
+				task = this->currentTask;
+				count = this->taskCount;
+			}
+
+			runTasks(*task, count);
+
+			{
+				std::lock_guard<std::mutex> lock(this->poolMutex);
+				this->busyWorkers--;
+			}
+			this->jobDone.notify_all();
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,74 @@
+#!/bin/sh
+#Profile guided optimization pipeline for the Linux build
+#Usage: ./pgo.sh [output directory]
+#1. Builds a plain release build (release), an instrumented build (instrumented) and, after training, a build optimized with its profiles (optimized), all with LTO
+#2. Trains the instrumented build on generated instances of every instance class and on the micro benchmarks
+#3. Runs the release and the optimized build on evaluation instances drawn with another seed and writes PgoReport.txt
+#Environment: PGO_TRAIN_SIZES and PGO_EVAL_SIZES (nb items of the training and evaluation instances), CMAKE_ARGS (extra configure arguments)
+set -e
+
+SOURCE_DIR=$(cd "$(dirname "$0")" && pwd)
+OUTPUT_DIR=$(mkdir -p "${1:-$SOURCE_DIR/pgo}" && cd "${1:-$SOURCE_DIR/pgo}" && pwd)
+TRAIN_SIZES=${PGO_TRAIN_SIZES:-"200 500"}
+EVAL_SIZES=${PGO_EVAL_SIZES:-"500 2000"}
+PROFILE_DIR="$OUTPUT_DIR/profiles"
+JOBS=$(nproc 2>/dev/null || echo 4)
+
+#Configure and build a variant
+#Arguments: build directory name, PGO stage
+build()
+{
+	cmake -S "$SOURCE_DIR" -B "$OUTPUT_DIR/$1" -DCMAKE_BUILD_TYPE=Release -DBINPACKING_LTO=ON -DBINPACKING_PGO="$2" -DBINPACKING_PGO_DIR="$PROFILE_DIR" $CMAKE_ARGS > "$OUTPUT_DIR/$1.log"
+	cmake --build "$OUTPUT_DIR/$1" -j"$JOBS" >> "$OUTPUT_DIR/$1.log"
+}
+
+#Run the macro benchmark of a build on every instance class, in a working directory two levels below the one that gets the generated instances
+#Arguments: build directory name, run name, seed, sizes
+runMacro()
+{
+	workDir="$OUTPUT_DIR/work/$2/run"
+	rm -rf "$OUTPUT_DIR/work/$2"
+	mkdir -p "$workDir/Results"
+	for instanceClass in 1 2 3 4 5
+	do
+		(cd "$workDir" && "$OUTPUT_DIR/$1/MacroBenchmark" --class $instanceClass --seed $3 --output "Class$instanceClass.txt" $4 > /dev/null)
+		if [ $instanceClass -eq 1 ]; then cat "$workDir/Class1.txt"; else tail -n +2 "$workDir/Class$instanceClass.txt"; fi
+	done > "$OUTPUT_DIR/$2.txt"
+}
+
+echo "Building the release and the instrumented builds"
+rm -rf "$PROFILE_DIR"
+build release OFF
+build instrumented GENERATE
+
+echo "Training on sizes $TRAIN_SIZES"
+runMacro instrumented training 1 "$TRAIN_SIZES"
+(cd "$OUTPUT_DIR/work" && "$OUTPUT_DIR/instrumented/MicroBenchmarks" --quick --output MicroTraining.txt > /dev/null)
+
+#Clang writes raw profiles that are merged into the file the USE build reads
+if ls "$PROFILE_DIR"/*.profraw > /dev/null 2>&1
+then
+	llvm-profdata merge -output="$PROFILE_DIR/default.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "Building the optimized build"
+build optimized USE
+
+echo "Evaluating on sizes $EVAL_SIZES"
+runMacro release release 2 "$EVAL_SIZES"
+runMacro optimized optimized 2 "$EVAL_SIZES"
+(cd "$OUTPUT_DIR/work" && "$OUTPUT_DIR/release/MicroBenchmarks" --output MicroRelease.txt > /dev/null)
+set +e
+(cd "$OUTPUT_DIR/work" && "$OUTPUT_DIR/optimized/MicroBenchmarks" --output MicroOptimized.txt --baseline MicroRelease.txt > MicroComparison.txt)
+set -e
+
+#Report: one line per evaluation instance and per kernel, release against optimized
+{
+	printf "Instance\tReleaseSeconds\tOptimizedSeconds\tSpeedup\tReleaseBins\tOptimizedBins\n"
+	paste "$OUTPUT_DIR/release.txt" "$OUTPUT_DIR/optimized.txt" | tail -n +2 | awk -F'\t' '{ printf "%s\t%.3f\t%.3f\t%.3f\t%s\t%s\n", $1, $3, $9, $3 / $9, $5, $11 }'
+	echo
+	printf "Kernel\tReleaseNsPerOp\tOptimizedNsPerOp\tSpeedup\n"
+	paste "$OUTPUT_DIR/work/MicroRelease.txt" "$OUTPUT_DIR/work/MicroOptimized.txt" | tail -n +2 | awk -F'\t' '{ printf "%s\t%.1f\t%.1f\t%.3f\n", $1, $2, $6, $2 / $6 }'
+} > "$OUTPUT_DIR/PgoReport.txt"
+
+cat "$OUTPUT_DIR/PgoReport.txt"